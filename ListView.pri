@@ -4,20 +4,45 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++11
 
+# 启用 ListView 运行时统计 (ListView::stats)，未定义时统计代码不会被编译
+#DEFINES += LISTVIEW_STATS
+
+# 启用 ListView 性能追踪埋点 (ListViewTrace)，未定义时埋点代码不会被编译
+#DEFINES += LISTVIEW_TRACE
+
 
 SOURCES += \   
     $$PWD/ListView/smoothscrollarea.cpp \
     $$PWD/ListView/listdatamodel.cpp \
     $$PWD/ListView/listviewdelegate.cpp \
     $$PWD/ListView/listview.cpp \
-    $$PWD/ListView/listviewitem.cpp
+    $$PWD/ListView/listviewitem.cpp \
+    $$PWD/ListView/listviewtrace.cpp \
+    $$PWD/ListView/listheightindex.cpp \
+    $$PWD/ListView/listlayoutengine.cpp \
+    $$PWD/ListView/listverticallayout.cpp \
+    $$PWD/ListView/listgridlayout.cpp \
+    $$PWD/ListView/listmasonrylayout.cpp \
+    $$PWD/ListView/listmutationqueue.cpp \
+    $$PWD/ListView/listfiltermodel.cpp \
+    $$PWD/ListView/listsortmodel.cpp \
+    $$PWD/ListView/listlayoutsnapshot.cpp \
+    $$PWD/ListView/listtextmeasurer.cpp \
+    $$PWD/ListView/listtreemodel.cpp \
+    $$PWD/ListView/listdatacache.cpp
 
 HEADERS += \
     $$PWD/ListView/smoothscrollarea.h \
     $$PWD/ListView/listdatamodel.h \
     $$PWD/ListView/listviewdelegate.h \
     $$PWD/ListView/listview.h \
-    $$PWD/ListView/listviewitem.h
+    $$PWD/ListView/listviewitem.h \
+    $$PWD/ListView/listviewtrace.h \
+    $$PWD/ListView/listfiltermodel.h \
+    $$PWD/ListView/listsortmodel.h \
+    $$PWD/ListView/listtextmeasurer.h \
+    $$PWD/ListView/listtreemodel.h \
+    $$PWD/ListView/listdatacache.h
 
 INCLUDEPATH += $$PWD
 
@@ -0,0 +1,308 @@
+#include "listdatacache_p.h"
+#include <QRunnable>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace
+{
+
+class ListDataCacheTask : public QRunnable
+{
+public:
+    explicit ListDataCacheTask(const std::shared_ptr<ListDataCacheShared>& shared) : shared(shared) {}
+
+    void run() override
+    {
+        ListDataCacheShared::work(shared);
+    }
+
+private:
+    std::shared_ptr<ListDataCacheShared> shared;
+};
+
+}
+
+ListDataCacheBase::ListDataCacheBase(ListDataModel *model, PageLoader loader, int pageSize) : priv(new ListDataCachePriv)
+{
+    priv->model = model;
+    priv->pageSize = std::max(1, pageSize);
+    priv->shared = std::make_shared<ListDataCacheShared>();
+    priv->shared->loader = std::move(loader);
+}
+
+ListDataCacheBase::~ListDataCacheBase()
+{
+    // 排队中的页不再加载，等待正在加载的页结束
+    {
+        std::lock_guard<std::mutex> lock(priv->shared->mutex);
+        priv->shared->cancelled = true;
+        priv->shared->queue.clear();
+    }
+    waitForPrefetch();
+    delete priv;
+}
+
+int ListDataCacheBase::pageSize() const
+{
+    return priv->pageSize;
+}
+
+void ListDataCacheBase::setCapacity(int pages)
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    priv->shared->capacity = std::max(1, pages);
+    priv->shared->evict();
+}
+
+int ListDataCacheBase::capacity() const
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    return priv->shared->capacity;
+}
+
+void ListDataCacheBase::setPrefetchMargin(int pages)
+{
+    priv->margin = std::max(0, pages);
+}
+
+void ListDataCacheBase::prefetch(const ListIndex &first, const ListIndex &last)
+{
+    if (first.isEmpty() || last.isEmpty() || last < first)
+    {
+        return;
+    }
+
+    // 先是可见范围内的页，再由近到远交替加入之后与之前的页
+    std::deque<ListDataPageRequest> requests;
+    ListDataPageRequest request;
+    const auto size = priv->pageSize;
+    for (auto group = first.group; group <= last.group; group++)
+    {
+        const auto numItems = priv->model->numItemsInGroup(group);
+        const auto begin = group == first.group ? std::max(0, first.item) : 0;
+        const auto end = group == last.group ? std::min(std::max(0, last.item), numItems - 1) : numItems - 1;
+        for (auto page = begin / size; page <= end / size && end >= begin; page++)
+        {
+            if (priv->makeRequest(group, page, request))
+            {
+                requests.push_back(request);
+            }
+        }
+    }
+    const auto firstPage = std::max(0, first.item) / size;
+    const auto lastPage = std::max(0, last.item) / size;
+    for (auto distance = 1; distance <= priv->margin; distance++)
+    {
+        if (priv->makeRequest(last.group, lastPage + distance, request))
+        {
+            requests.push_back(request);
+        }
+        if (priv->makeRequest(first.group, firstPage - distance, request))
+        {
+            requests.push_back(request);
+        }
+    }
+
+    auto& shared = priv->shared;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->queue.clear();
+    for (auto& item : requests)
+    {
+        if (!shared->pages.count(item.key) && !shared->loading.count(item.key))
+        {
+            shared->queue.push_back(item);
+        }
+    }
+    if (!shared->running && !shared->queue.empty())
+    {
+        shared->running = true;
+        QThreadPool::globalInstance()->start(new ListDataCacheTask(shared));
+    }
+}
+
+void ListDataCacheBase::waitForPrefetch()
+{
+    std::unique_lock<std::mutex> lock(priv->shared->mutex);
+    priv->shared->finished.wait(lock, [this]{return !priv->shared->running;});
+}
+
+void ListDataCacheBase::invalidate(const ListIndex &index)
+{
+    if (index.isEmpty() || index.isHeader())
+    {
+        return;
+    }
+    auto& shared = priv->shared;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    auto it = shared->pages.find({index.group, index.item / priv->pageSize});
+    if (it != shared->pages.end())
+    {
+        shared->erase(it, std::next(it));
+    }
+    // 只丢弃这一页正在进行的加载，其他页的预取不受影响
+    auto loading = shared->loading.find({index.group, index.item / priv->pageSize});
+    if (loading != shared->loading.end())
+    {
+        shared->discardLoading(loading, std::next(loading));
+    }
+}
+
+void ListDataCacheBase::invalidate(int group)
+{
+    auto& shared = priv->shared;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->erase(shared->pages.lower_bound({group, 0}), shared->pages.lower_bound({group + 1, 0}));
+    shared->discardLoading(shared->loading.lower_bound({group, 0}), shared->loading.lower_bound({group + 1, 0}));
+    // 排队的请求按修改前的数据项数目计算了页的范围，也要丢弃
+    auto& queue = shared->queue;
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [group](const ListDataPageRequest& request){return request.key.group == group;}), queue.end());
+}
+
+void ListDataCacheBase::clear()
+{
+    auto& shared = priv->shared;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->erase(shared->pages.begin(), shared->pages.end());
+    shared->queue.clear();
+    shared->discardLoading(shared->loading.begin(), shared->loading.end());
+}
+
+size_t ListDataCacheBase::cachedPages() const
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    return priv->shared->pages.size();
+}
+
+ListDataCacheBase::PagePtr ListDataCacheBase::page(const ListIndex &index, int *offset)
+{
+    ListDataPageRequest request;
+    if (index.isEmpty() || index.isHeader() || !priv->makeRequest(index.group, index.item / priv->pageSize, request))
+    {
+        return nullptr;
+    }
+    *offset = index.item - request.first;
+
+    auto& shared = priv->shared;
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    while (shared->loading.count(request.key))
+    {
+        // 正在预取的页，等待它完成而不是重复加载
+        shared->finished.wait(lock);
+    }
+    if (auto result = shared->find(request.key))
+    {
+        return result;
+    }
+
+    shared->loading[request.key] = false;
+    lock.unlock();
+    auto result = shared->loader(request.key.group, request.first, request.count);
+    lock.lock();
+    auto loading = shared->loading.find(request.key);
+    const auto discarded = loading->second;
+    shared->loading.erase(loading);
+    if (!discarded)
+    {
+        shared->insert(request.key, result);
+    }
+    shared->finished.notify_all();
+    return result;
+}
+
+
+
+ListDataCacheBase::PagePtr ListDataCacheShared::find(const ListDataPageKey &key)
+{
+    auto it = pages.find(key);
+    if (it == pages.end())
+    {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second.lruPos);
+    return it->second.page;
+}
+
+void ListDataCacheShared::insert(const ListDataPageKey &key, const ListDataCacheBase::PagePtr &page)
+{
+    auto it = pages.find(key);
+    if (it != pages.end())
+    {
+        it->second.page = page;
+        lru.splice(lru.begin(), lru, it->second.lruPos);
+        return;
+    }
+    lru.push_front(key);
+    pages[key] = {page, lru.begin()};
+    evict();
+}
+
+void ListDataCacheShared::erase(std::map<ListDataPageKey, Entry>::iterator first, std::map<ListDataPageKey, Entry>::iterator last)
+{
+    for (auto it = first; it != last; it++)
+    {
+        lru.erase(it->second.lruPos);
+    }
+    pages.erase(first, last);
+}
+
+void ListDataCacheShared::evict()
+{
+    while ((int)pages.size() > capacity)
+    {
+        // 页被淘汰后，已经取出的数据项仍由调用者持有
+        pages.erase(lru.back());
+        lru.pop_back();
+    }
+}
+
+void ListDataCacheShared::discardLoading(std::map<ListDataPageKey, bool>::iterator first, std::map<ListDataPageKey, bool>::iterator last)
+{
+    for (auto it = first; it != last; it++)
+    {
+        it->second = true;
+    }
+}
+
+void ListDataCacheShared::work(const std::shared_ptr<ListDataCacheShared> &shared)
+{
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    while (!shared->cancelled && !shared->queue.empty())
+    {
+        const auto request = shared->queue.front();
+        shared->queue.pop_front();
+        if (shared->pages.count(request.key) || shared->loading.count(request.key))
+        {
+            continue;
+        }
+
+        shared->loading[request.key] = false;
+        lock.unlock();
+        auto page = shared->loader(request.key.group, request.first, request.count);
+        lock.lock();
+        auto loading = shared->loading.find(request.key);
+        const auto discarded = loading->second;
+        shared->loading.erase(loading);
+        if (!discarded && !shared->cancelled)
+        {
+            shared->insert(request.key, page);
+        }
+        shared->finished.notify_all();
+    }
+    shared->running = false;
+    shared->finished.notify_all();
+}
+
+
+
+bool ListDataCachePriv::makeRequest(int group, int page, ListDataPageRequest &request) const
+{
+    if (page < 0 || group < 0 || group >= model->numGroups())
+    {
+        return false;
+    }
+    const auto numItems = model->numItemsInGroup(group);
+    request.key = {group, page};
+    request.first = page * pageSize;
+    request.count = std::min(pageSize, numItems - request.first);
+    return request.count > 0;
+}
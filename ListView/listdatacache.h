@@ -0,0 +1,121 @@
+#ifndef LISTDATACACHE_H
+#define LISTDATACACHE_H
+
+#include "listdatamodel.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * 分页数据缓存的类型无关部分，见 ListDataCache
+ */
+class ListDataCacheBase
+{
+public:
+    typedef std::shared_ptr<void> PagePtr;
+
+    /**
+     * 加载一页数据：分组 group 中从 first 开始的 count 个数据项
+     */
+    typedef std::function<PagePtr(int group, int first, int count)> PageLoader;
+
+    ListDataCacheBase(ListDataModel* model, PageLoader loader, int pageSize);
+    virtual ~ListDataCacheBase();
+
+    int pageSize() const;
+
+    /**
+     * 最多缓存的页数，超出时淘汰最久没有使用的页，默认为 64
+     * 应不少于可见范围的页数加上前后预取的页数
+     */
+    void setCapacity(int pages);
+    int capacity() const;
+
+    /**
+     * 预取时在可见范围之前与之后各多取的页数，默认为 2
+     */
+    void setPrefetchMargin(int pages);
+
+    /**
+     * 在工作线程中按顺序加载覆盖 [first, last] 及其前后 margin 页的数据，立即返回
+     * 通常连接到 ListView::visibleRangeChanged 。尚未开始加载的旧请求被新的范围替换，滚动时不会堆积。
+     */
+    void prefetch(const ListIndex& first, const ListIndex& last);
+
+    /**
+     * 等待正在进行的预取完成
+     */
+    void waitForPrefetch();
+
+    /**
+     * 丢弃缓存的页，范围内正在加载与等待预取的页也会被丢弃，范围外的预取不受影响
+     * 数据项更新时丢弃其所在的页；分组中插入或删除数据项时丢弃整个分组；分组本身插入删除或重新加载时 clear
+     */
+    void invalidate(const ListIndex& index);
+    void invalidate(int group);
+    void clear();
+
+    size_t cachedPages() const;
+
+protected:
+    /**
+     * 返回 index 所在的页，offset 为 index 在页中的位置；未命中时在当前线程加载，该页正在预取时等待预取完成
+     * 索引无效时返回空指针
+     */
+    PagePtr page(const ListIndex& index, int* offset);
+
+private:
+    class ListDataCachePriv* priv;
+};
+
+/**
+ * 分页数据缓存
+ * 把数据模型的数据项按分组分成固定大小的页，以页为单位加载并缓存，淘汰最久没有使用的页 (LRU) ，
+ * 并在工作线程中预取可见范围附近的页，使 delegate 在 prepareItemView 中取数据时直接命中内存，而不是每次滚动都查询数据库。
+ *
+ * 所有权：页由缓存与取出的数据项共同持有。item 返回的 shared_ptr 引用整页数据，
+ * 即使该页随后被淘汰或丢弃，持有期间数据项仍然有效；不再持有时随页一起释放。
+ * 因此不要通过 ListDataModel::data 返回缓存中的裸指针，缓存随时可能在工作线程中淘汰页。
+ *
+ * 使用方法：
+ * 1. 数据模型（或 delegate）持有 ListDataCache<T> ，加载函数从数据库等可以在工作线程读取的数据源读取一页
+ * 2. 把 ListView::visibleRangeChanged 连接到 prefetch
+ * 3. 在 heightForIndex / prepareItemView 中调用 item
+ * 4. 数据修改时按 invalidate 的说明丢弃对应的页
+ *
+ * 加载函数会在工作线程中调用，只能读取可以并发读取的数据；分组的数据项数目在调用线程中从数据模型读取。
+ * 除加载函数之外的接口都应在 UI 线程调用，缓存不能比数据模型存在得更久。
+ */
+template<class T>
+class ListDataCache : public ListDataCacheBase
+{
+public:
+    /**
+     * 加载函数，返回分组 group 中从 first 开始的 count 个数据项
+     */
+    typedef std::function<std::vector<T>(int group, int first, int count)> Loader;
+
+    ListDataCache(ListDataModel* model, Loader loader, int pageSize = 256)
+        : ListDataCacheBase(model, [loader](int group, int first, int count) -> PagePtr
+          {
+              return std::make_shared<std::vector<T>>(loader(group, first, count));
+          }, pageSize)
+    {
+    }
+
+    /**
+     * 返回数据项，索引无效或加载函数返回的数据不足时返回空指针
+     */
+    std::shared_ptr<const T> item(const ListIndex& index)
+    {
+        int offset = 0;
+        auto items = std::static_pointer_cast<const std::vector<T>>(page(index, &offset));
+        if (!items || offset >= (int)items->size())
+        {
+            return nullptr;
+        }
+        return std::shared_ptr<const T>(items, &(*items)[offset]);
+    }
+};
+
+#endif // LISTDATACACHE_H
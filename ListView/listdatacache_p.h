@@ -0,0 +1,92 @@
+#ifndef LISTDATACACHE_P_H
+#define LISTDATACACHE_P_H
+
+#include "listdatacache.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+
+/**
+ * 页的键：分组与页号
+ */
+struct ListDataPageKey
+{
+    int group;
+    int page;
+
+    bool operator<(const ListDataPageKey& other) const
+    {
+        return group < other.group || (group == other.group && page < other.page);
+    }
+};
+
+/**
+ * 一次加载请求，first 与 count 在 UI 线程中按分组的数据项数目计算
+ */
+struct ListDataPageRequest
+{
+    ListDataPageKey key;
+    int first;
+    int count;
+};
+
+/**
+ * 工作线程与缓存共享的状态
+ * 缓存删除时设置 cancelled 、清空队列并等待 running 变为 false
+ */
+struct ListDataCacheShared
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool running = false;
+    std::atomic<bool> cancelled{false};
+
+    ListDataCacheBase::PageLoader loader;
+    int capacity = 64;
+
+    struct Entry
+    {
+        ListDataCacheBase::PagePtr page;
+        std::list<ListDataPageKey>::iterator lruPos;
+    };
+    std::map<ListDataPageKey, Entry> pages;
+    // 最近使用的页在前
+    std::list<ListDataPageKey> lru;
+    // 正在加载（工作线程或同步加载）的页，值为加载开始之后是否被丢弃，被丢弃的页加载完成后不再写入缓存
+    std::map<ListDataPageKey, bool> loading;
+    // 等待预取的页，按距离可见范围由近到远排列
+    std::deque<ListDataPageRequest> queue;
+
+    /**
+     * 以下函数调用时需持有 mutex
+     */
+    ListDataCacheBase::PagePtr find(const ListDataPageKey& key);
+    void insert(const ListDataPageKey& key, const ListDataCacheBase::PagePtr& page);
+    void erase(std::map<ListDataPageKey, Entry>::iterator first, std::map<ListDataPageKey, Entry>::iterator last);
+    void evict();
+    void discardLoading(std::map<ListDataPageKey, bool>::iterator first, std::map<ListDataPageKey, bool>::iterator last);
+
+    /**
+     * 工作线程：依次加载队列中的页，直到队列为空或被取消
+     */
+    static void work(const std::shared_ptr<ListDataCacheShared>& shared);
+};
+
+class ListDataCachePriv
+{
+public:
+    ListDataModel* model;
+    int pageSize;
+    int margin = 2;
+    std::shared_ptr<ListDataCacheShared> shared;
+
+    /**
+     * 页 page 的请求，超出分组末尾时返回 false
+     */
+    bool makeRequest(int group, int page, ListDataPageRequest& request) const;
+};
+
+#endif // LISTDATACACHE_P_H
@@ -1,5 +1,9 @@
 #include "listdatamodel_p.h"
 #include "listview_p.h"
+#include <QTimer>
+
+// 流式追加的通知周期，约为一帧
+static const int ListDataModelFlushInterval = 16;
 
 ListIndex::ListIndex(){}
 
@@ -21,11 +25,14 @@ bool ListIndex::operator<=(const ListIndex &other) const {return *this < other |
 
 bool ListIndex::operator>=(const ListIndex &other) const {return *this > other || *this == other;}
 
+ListIndexRange::ListIndexRange(const ListIndex &first, size_t count) : first(first), count(count) {}
+
 
 
 ListDataModel::ListDataModel() : priv(new ListDataModelPriv)
 {
     priv->owner = this;
+    priv->dispatcher = new QObject();
 }
 
 ListDataModel::~ListDataModel()
@@ -50,11 +57,79 @@ bool ListDataModel::isEmpty()
     return result;
 }
 
+quint64 ListDataModel::contentVersion()
+{
+    return 0;
+}
+
+int ListDataModel::depthForIndex(const ListIndex &)
+{
+    return 0;
+}
+
+bool ListDataModel::hasMoreItems(int)
+{
+    return false;
+}
+
+void ListDataModel::fetchMoreItems(int)
+{
+
+}
+
 void *ListDataModel::dataForIndex(const ListIndex &)
 {
     return nullptr;
 }
 
+void ListDataModel::dropLeadingGroup()
+{
+
+}
+
+void ListDataModel::dropLeadingItems(int)
+{
+
+}
+
+void ListDataModel::flushAppends()
+{
+    if (priv->flushTimer)
+    {
+        priv->flushTimer->stop();
+    }
+    // 合并的更新都是已通知的数据项，在追加与丢弃头部数据改变索引之前通知
+    flushUpdates();
+
+    const auto items = priv->pendingItems;
+    const auto groups = priv->pendingGroups;
+    if (items == 0 && groups == 0)
+    {
+        return;
+    }
+    // 先清零，以下的 begin* 调用不会再次进入此函数
+    priv->pendingItems = 0;
+    priv->pendingGroups = 0;
+
+    // 数据已经在模型中，ListView 的 begin* 只记录修改信息，不会访问数据
+    priv->beginBatch();
+    const auto firstNewGroup = numGroups() - groups;
+    if (items)
+    {
+        const auto group = firstNewGroup - 1;
+        beginInsertItems(ListIndex(group, numItemsInGroup(group) - (int)items), items);
+        endInsertItems();
+    }
+    for (auto group = firstNewGroup; group < numGroups(); group++)
+    {
+        beginInsertGroup(group);
+        endInsertGroup();
+    }
+
+    trimToRetention();
+    priv->endBatch();
+}
+
 void ListDataModel::onRequestMoreLeadingData()
 {
 
@@ -67,26 +142,80 @@ void ListDataModel::onRequestMoreTailingData()
 
 void ListDataModel::requireReload()
 {
+    // 重新加载会读取全部数据，累积的追加与更新不需要再通知
+    priv->pendingItems = 0;
+    priv->pendingGroups = 0;
+    priv->pendingUpdates.clear();
+    priv->fetchingGroups.clear();
+    priv->itemTotal = -1;
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
         listViewPriv->requireReload();
     }
+    for (auto& observer : priv->observers)
+    {
+        observer->modelReloaded();
+    }
 }
 
 void ListDataModel::itemUpdated(const ListIndex &index)
 {
+    if (priv->coalesceUpdates)
+    {
+        // 累积的追加尚未通知，通知插入时会一并测量，不需要再记录更新
+        const auto firstNewGroup = numGroups() - priv->pendingGroups;
+        const auto appended = index.group >= firstNewGroup
+                || (index.group == firstNewGroup - 1 && index.item >= numItemsInGroup(index.group) - (int)priv->pendingItems);
+        if (!appended)
+        {
+            priv->pendingUpdates.insert(index);
+            scheduleFlush();
+        }
+        return;
+    }
+
+    flushAppends();
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
-        listViewPriv->itemUpdated(index);
+        listViewPriv->itemsUpdated(index, 1);
     }
+    for (auto& observer : priv->observers)
+    {
+        observer->modelItemUpdated(index);
+    }
+}
+
+void ListDataModel::itemsUpdated(const ListIndex &first, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    flushAppends();
+    notifyItemsUpdated(first, (int)count);
+}
+
+void ListDataModel::itemsUpdated(const std::vector<ListIndexRange> &ranges)
+{
+    priv->beginBatch();
+    for (auto& range : ranges)
+    {
+        itemsUpdated(range.first, range.count);
+    }
+    priv->endBatch();
 }
 
 void ListDataModel::beginInsertItems(const ListIndex &insertIndex, size_t count)
 {
+    flushAppends();
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
         listViewPriv->beginInsertItem(insertIndex, count);
     }
+    priv->beginChange(ListMutation::InsertItems, insertIndex, count);
 }
 
 void ListDataModel::endInsertItems()
@@ -95,14 +224,18 @@ void ListDataModel::endInsertItems()
     {
         listViewPriv->endInsertItem();
     }
+    priv->endChange();
 }
 
 void ListDataModel::beginInsertGroup(int groupIndex)
 {
+    flushAppends();
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
         listViewPriv->beginInsertGroup(groupIndex);
     }
+    priv->beginChange(ListMutation::InsertGroup, ListIndex(groupIndex), 1);
 }
 
 void ListDataModel::endInsertGroup()
@@ -111,14 +244,18 @@ void ListDataModel::endInsertGroup()
     {
         listViewPriv->endInsertGroup();
     }
+    priv->endChange();
 }
 
 void ListDataModel::beginRemoveItems(const ListIndex &removeIndex, size_t count)
 {
+    flushAppends();
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
         listViewPriv->beginRemoveItem(removeIndex, count);
     }
+    priv->beginChange(ListMutation::RemoveItems, removeIndex, count);
 }
 
 void ListDataModel::endRemoveItems()
@@ -127,14 +264,18 @@ void ListDataModel::endRemoveItems()
     {
         listViewPriv->endRemoveItem();
     }
+    priv->endChange();
 }
 
 void ListDataModel::beginRemoveGroup(int groupIndex)
 {
+    flushAppends();
+    priv->changeSerial++;
     for (auto& listViewPriv : priv->listViewPrivs)
     {
         listViewPriv->beginRemoveGroup(groupIndex);
     }
+    priv->beginChange(ListMutation::RemoveGroup, ListIndex(groupIndex), 1);
 }
 
 void ListDataModel::endRemoveGroup()
@@ -143,16 +284,434 @@ void ListDataModel::endRemoveGroup()
     {
         listViewPriv->endRemoveGroup();
     }
+    priv->endChange();
 }
 
+void ListDataModel::appendItems(size_t count)
+{
+    Q_ASSERT(numGroups() > 0);
+    if (priv->pendingGroups == 0)
+    {
+        // 追加到新分组中的数据项在通知插入分组时一并加载
+        priv->pendingItems += count;
+    }
+    scheduleFlush();
+}
+
+void ListDataModel::appendGroup()
+{
+    priv->pendingGroups++;
+    appendItems(0);
+}
+
+void ListDataModel::setRetentionLimit(int maxItems, int maxGroups)
+{
+    priv->maxItems = std::max(0, maxItems);
+    priv->maxGroups = std::max(0, maxGroups);
+}
 
+void ListDataModel::itemsFetched(int group, size_t count)
+{
+    priv->fetchingGroups.erase(group);
+    if (count == 0)
+    {
+        return;
+    }
+    // 数据已经在模型中，与通知流式追加一样，ListView 的 begin* 只记录修改信息
+    beginInsertItems(ListIndex(group, numItemsInGroup(group) - (int)count), count);
+    endInsertItems();
+}
+
+void ListDataModel::setUpdateCoalescing(bool enabled)
+{
+    if (!enabled)
+    {
+        flushUpdates();
+    }
+    priv->coalesceUpdates = enabled;
+}
+
+void ListDataModel::scheduleFlush()
+{
+    if (!priv->flushTimer)
+    {
+        priv->flushTimer = new QTimer();
+        priv->flushTimer->setSingleShot(true);
+        priv->flushTimer->callOnTimeout([=]{flushAppends();});
+    }
+    if (!priv->flushTimer->isActive())
+    {
+        priv->flushTimer->start(ListDataModelFlushInterval);
+    }
+}
+
+void ListDataModel::flushUpdates()
+{
+    if (priv->pendingUpdates.empty())
+    {
+        return;
+    }
+    std::set<ListIndex> updates;
+    updates.swap(priv->pendingUpdates);
+
+    // 有序的索引中同一分组内连续的数据项合并为一个区间，整批只做一次布局
+    priv->beginBatch();
+    auto it = updates.begin();
+    while (it != updates.end())
+    {
+        const auto first = *it;
+        auto count = 1;
+        while (++it != updates.end() && !first.isHeader() && *it == ListIndex(first.group, first.item + count))
+        {
+            count++;
+        }
+        notifyItemsUpdated(first, count);
+    }
+    priv->endBatch();
+}
+
+void ListDataModel::notifyItemsUpdated(const ListIndex &first, int count)
+{
+    priv->changeSerial++;
+    for (auto& listViewPriv : priv->listViewPrivs)
+    {
+        listViewPriv->itemsUpdated(first, count);
+    }
+    for (auto& observer : priv->observers)
+    {
+        observer->modelItemsUpdated(first, count);
+    }
+}
+
+void ListDataModel::trimToRetention()
+{
+    if (priv->maxGroups > 0 && numGroups() > priv->maxGroups)
+    {
+        removeLeadingGroups(numGroups() - priv->maxGroups);
+    }
+    if (priv->maxItems <= 0)
+    {
+        return;
+    }
+
+    if (priv->itemTotal < 0)
+    {
+        priv->itemTotal = 0;
+        for (int group = 0, n = numGroups(); group < n; group++)
+        {
+            priv->itemTotal += numItemsInGroup(group);
+        }
+    }
+    auto excess = int(priv->itemTotal - priv->maxItems);
+    // 整个分组都超出上限时丢弃分组，否则丢弃第一个分组开头的数据项
+    int groups = 0;
+    while (excess > 0 && groups + 1 < numGroups() && numItemsInGroup(groups) <= excess)
+    {
+        excess -= numItemsInGroup(groups);
+        groups++;
+    }
+    removeLeadingGroups(groups);
+    if (excess > 0)
+    {
+        beginRemoveItems(ListIndex(0, 0), excess);
+        dropLeadingItems(excess);
+        endRemoveItems();
+    }
+}
+
+void ListDataModel::removeLeadingGroups(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        beginRemoveGroup(0);
+        dropLeadingGroup();
+        endRemoveGroup();
+    }
+}
+
+void ListDataModel::postInsertItems(const ListIndex &insertIndex, size_t count, std::function<void()> apply)
+{
+    postMutation(ListMutation::InsertItems, insertIndex, count, std::move(apply));
+}
+
+void ListDataModel::postRemoveItems(const ListIndex &removeIndex, size_t count, std::function<void()> apply)
+{
+    postMutation(ListMutation::RemoveItems, removeIndex, count, std::move(apply));
+}
+
+void ListDataModel::postInsertGroup(int groupIndex, std::function<void()> apply)
+{
+    postMutation(ListMutation::InsertGroup, ListIndex(groupIndex), 1, std::move(apply));
+}
+
+void ListDataModel::postRemoveGroup(int groupIndex, std::function<void()> apply)
+{
+    postMutation(ListMutation::RemoveGroup, ListIndex(groupIndex), 1, std::move(apply));
+}
+
+void ListDataModel::postItemUpdated(const ListIndex &index, std::function<void()> apply)
+{
+    postMutation(ListMutation::UpdateItem, index, 1, std::move(apply));
+}
+
+void ListDataModel::postAppendItems(size_t count, std::function<void()> apply)
+{
+    postMutation(ListMutation::AppendItems, ListIndex(), count, std::move(apply));
+}
+
+void ListDataModel::postAppendGroup(std::function<void()> apply)
+{
+    postMutation(ListMutation::AppendGroup, ListIndex(), 0, std::move(apply));
+}
+
+void ListDataModel::postReload(std::function<void()> apply)
+{
+    postMutation(ListMutation::Reload, ListIndex(), 0, std::move(apply));
+}
+
+void ListDataModel::postMutation(int type, const ListIndex &index, size_t count, std::function<void()> &&apply)
+{
+    ListMutation mutation;
+    mutation.type = ListMutation::Type(type);
+    mutation.index = index;
+    mutation.count = count;
+    mutation.apply = apply ? std::move(apply) : []{};
+    priv->mutations.push(std::move(mutation));
+
+    // 记录完整入队之后再设置标记，队列非空时最多只投递一次
+    if (!priv->drainScheduled.exchange(true))
+    {
+        QMetaObject::invokeMethod(priv->dispatcher, [=]{drainMutations();}, Qt::QueuedConnection);
+    }
+}
+
+void ListDataModel::drainMutations()
+{
+    // 先清除标记再取出记录：之后入队的记录会重新投递，不会遗漏
+    priv->drainScheduled.exchange(false);
+
+    ListMutation mutation;
+    if (!priv->mutations.pop(mutation))
+    {
+        return;
+    }
+
+    priv->beginBatch();
+    do
+    {
+        switch (mutation.type)
+        {
+        case ListMutation::InsertItems:
+            beginInsertItems(mutation.index, mutation.count);
+            mutation.apply();
+            endInsertItems();
+            break;
+        case ListMutation::RemoveItems:
+            beginRemoveItems(mutation.index, mutation.count);
+            mutation.apply();
+            endRemoveItems();
+            break;
+        case ListMutation::InsertGroup:
+            beginInsertGroup(mutation.index.group);
+            mutation.apply();
+            endInsertGroup();
+            break;
+        case ListMutation::RemoveGroup:
+            beginRemoveGroup(mutation.index.group);
+            mutation.apply();
+            endRemoveGroup();
+            break;
+        case ListMutation::UpdateItem:
+            mutation.apply();
+            itemUpdated(mutation.index);
+            break;
+        case ListMutation::AppendItems:
+            mutation.apply();
+            appendItems(mutation.count);
+            break;
+        case ListMutation::AppendGroup:
+            mutation.apply();
+            appendGroup();
+            break;
+        case ListMutation::Reload:
+            mutation.apply();
+            requireReload();
+            break;
+        }
+    } while (priv->mutations.pop(mutation));
+    priv->endBatch();
+}
+
+void ListDataModelPriv::beginBatch()
+{
+    for (auto& listViewPriv : listViewPrivs)
+    {
+        listViewPriv->beginBatch();
+    }
+    for (auto& observer : observers)
+    {
+        observer->modelBatchBegin();
+    }
+}
+
+void ListDataModelPriv::endBatch()
+{
+    for (auto& listViewPriv : listViewPrivs)
+    {
+        listViewPriv->endBatch();
+    }
+    for (auto& observer : observers)
+    {
+        observer->modelBatchEnd();
+    }
+}
+
+void ListDataModelPriv::beginChange(ListMutation::Type type, const ListIndex &index, size_t count)
+{
+    change.type = type;
+    change.index = index;
+    change.count = count;
+    if (itemTotal >= 0 && type == ListMutation::RemoveItems)
+    {
+        itemTotal -= count;
+    }
+    else if (itemTotal >= 0 && type == ListMutation::RemoveGroup)
+    {
+        itemTotal -= owner->numItemsInGroup(index.group);
+    }
+    if (!fetchingGroups.empty() && (type == ListMutation::InsertGroup || type == ListMutation::RemoveGroup))
+    {
+        // 正在请求的分组随分组的插入删除调整索引，被删除的分组不再等待
+        std::set<int> shifted;
+        for (auto group : fetchingGroups)
+        {
+            if (group < index.group)
+            {
+                shifted.insert(group);
+            }
+            else if (type == ListMutation::InsertGroup)
+            {
+                shifted.insert(group + 1);
+            }
+            else if (group > index.group)
+            {
+                shifted.insert(group - 1);
+            }
+        }
+        fetchingGroups.swap(shifted);
+    }
+    for (auto& observer : observers)
+    {
+        observer->modelAboutToChange();
+    }
+}
+
+void ListDataModelPriv::requestMoreItems(int group)
+{
+    if (fetchingGroups.count(group) || !owner->hasMoreItems(group))
+    {
+        return;
+    }
+    fetchingGroups.insert(group);
+    owner->fetchMoreItems(group);
+}
+
+void ListDataModelPriv::endChange()
+{
+    if (itemTotal >= 0 && change.type == ListMutation::InsertItems)
+    {
+        itemTotal += change.count;
+    }
+    else if (itemTotal >= 0 && change.type == ListMutation::InsertGroup)
+    {
+        itemTotal += owner->numItemsInGroup(change.index.group);
+    }
+    for (auto& observer : observers)
+    {
+        switch (change.type)
+        {
+        case ListMutation::InsertItems:
+            observer->modelItemsInserted(change.index, (int)change.count);
+            break;
+        case ListMutation::RemoveItems:
+            observer->modelItemsRemoved(change.index, (int)change.count);
+            break;
+        case ListMutation::InsertGroup:
+            observer->modelGroupInserted(change.index.group);
+            break;
+        case ListMutation::RemoveGroup:
+            observer->modelGroupRemoved(change.index.group);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+ListDataModelObserver::~ListDataModelObserver()
+{
+}
+
+void ListDataModelObserver::modelItemsUpdated(const ListIndex &first, int count)
+{
+    for (int item = first.item; item < first.item + count; item++)
+    {
+        modelItemUpdated(ListIndex(first.group, item));
+    }
+}
 
 ListDataModelPriv::~ListDataModelPriv()
 {
+    delete dispatcher;
+    delete flushTimer;
+    // 视图解除关联时可能把本模型的状态保存为观察者，因此先解除视图再通知观察者
     while (!listViewPrivs.empty())
     {
         (*listViewPrivs.begin())->setDataModel(nullptr);
     }
+    while (!observers.empty())
+    {
+        // 先移除再通知，观察者在 modelDestroyed 中不需要再访问本模型
+        auto observer = *observers.begin();
+        observers.erase(observers.begin());
+        observer->modelDestroyed();
+    }
+}
+
+ListHeightStore *ListDataModelPriv::acquireHeights(const QString &key, int mode, int width)
+{
+    if (!key.isEmpty())
+    {
+        for (auto store : heightStores)
+        {
+            if (store->key == key && store->mode == mode && store->width == width)
+            {
+                store->refs++;
+                return store;
+            }
+        }
+    }
+
+    auto store = new ListHeightStore();
+    store->key = key;
+    store->mode = mode;
+    store->width = width;
+    store->refs = 1;
+    if (!key.isEmpty())
+    {
+        heightStores.push_back(store);
+    }
+    return store;
+}
+
+void ListDataModelPriv::releaseHeights(ListHeightStore *store)
+{
+    if (--store->refs > 0)
+    {
+        return;
+    }
+    heightStores.remove(store);
+    delete store;
 }
 
 ListDataModelPriv *ListDataModel::getPriv() const
@@ -2,6 +2,8 @@
 #define LISTDATAMODEL_H
 
 #include <inttypes.h>
+#include <functional>
+#include <vector>
 #include <QtGlobal>
 
 class ListIndex
@@ -23,6 +25,17 @@ public:
     int32_t item = InvalidItemIndex;
 };
 
+/**
+ * 同一分组中从 first 开始的 count 个连续数据项
+ */
+class ListIndexRange
+{
+public:
+    ListIndexRange(const ListIndex& first, size_t count);
+    ListIndex first;
+    size_t count;
+};
+
 
 /**
  * 列表数据模型
@@ -42,6 +55,26 @@ public:
      */
     virtual int numItemsInGroup(int group) = 0;
 
+    /**
+     * 子类可选择实现此接口，返回数据内容的版本号，用于校验 ListView 的布局快照 (ListView::restoreLayoutSnapshot)
+     * 数据项的数目或展示高度改变后应返回不同的值。
+     * 默认实现返回 0 ，表示不提供版本，快照不会被使用
+     */
+    virtual quint64 contentVersion();
+
+    /**
+     * 子类可选择实现此接口，返回数据项的缩进层级，ListView 在 prepareItemView 之前设置到 ListViewItem::depth
+     * 默认实现返回 0 ，树形模型 (ListTreeModel) 返回节点的层级
+     */
+    virtual int depthForIndex(const ListIndex& index);
+
+    /**
+     * 分页加载的子类应实现此接口：分组中还有尚未取得的数据项时返回 true ，
+     * 此时 numItemsInGroup 返回的只是已经取得的数目（至少有这么多）。
+     * 默认实现返回 false
+     */
+    virtual bool hasMoreItems(int group);
+
     /// 以下是子类可实现的保护接口
 protected:
     /**
@@ -51,6 +84,25 @@ protected:
      */
     virtual void* dataForIndex(const ListIndex& index);
 
+    /**
+     * 设置了保留上限 (setRetentionLimit) 的子类应实现此函数，删除第一个分组及其中的所有数据项
+     * 此函数由本类在超出上限时调用，调用前后已通知 ListView ，子类只需删除数据
+     */
+    virtual void dropLeadingGroup();
+
+    /**
+     * 设置了保留上限的子类应实现此函数，删除第一个分组中最前面的 count 个数据项
+     */
+    virtual void dropLeadingItems(int count);
+
+    /**
+     * 分页加载的子类应实现此函数，开始取得分组 group 的下一页数据项，可以是异步的
+     * hasMoreItems(group) 为 true 并且 ListView 加载到分组已知的末尾附近时，在下一次事件循环中调用；
+     * 同一分组在这一页到达 (itemsFetched) 之前不会被重复请求，多个 ListView 展示同一数据模型时也只请求一次。
+     * 默认实现不做任何处理。
+     */
+    virtual void fetchMoreItems(int group);
+
 
 public:
     ListDataModel();
@@ -58,6 +110,10 @@ public:
 
     ///以下是本类实现的公有接口
 public:
+    /**
+     * 返回 dataForIndex 的结果，指针的有效期由子类决定
+     * 数据需要从数据库等较慢的数据源读取时，可以用 ListDataCache 分页缓存并预取，由它管理数据的生命周期
+     */
     template <class T>
     T* data(const ListIndex& index)
     {
@@ -67,6 +123,12 @@ public:
     ListIndex maxIndex();
     bool isEmpty();
 
+    /**
+     * 立即把 appendItems / appendGroup 累积的追加以及合并的更新 (setUpdateCoalescing) 通知给 ListView ，并按保留上限丢弃最早的数据
+     * 通常不需要手动调用，累积的追加与更新每帧会自动通知一次
+     */
+    void flushAppends();
+
 
 protected:
     /**
@@ -99,6 +161,17 @@ protected:
      */
     void itemUpdated(const ListIndex& index);
 
+    /**
+     * 当分组中从 first 开始的 count 个数据项有更新时，调用此函数
+     * 与逐个调用 itemUpdated 相比，整个区间一次测量，ListView 只做一次布局和视图调整。
+     */
+    void itemsUpdated(const ListIndex& first, size_t count);
+
+    /**
+     * 多个区间（可以在不同分组中）有更新时，调用此函数，所有区间合并为一次布局
+     */
+    void itemsUpdated(const std::vector<ListIndexRange>& ranges);
+
     /**
      * 通知 ListView 即将插入数据，仅支持在同一个分组中插入数据。
      * 如果要在多个分组中插入数据项，请根据分组索引分次插入。
@@ -175,7 +248,91 @@ protected:
      */
     void endRemoveGroup();
 
+    /**
+     * 流式追加数据项：子类在最后一个分组的末尾追加了 count 个数据项之后调用此函数。
+     * 与 beginInsertItems / endInsertItems 不同，追加不会立即通知 ListView ，
+     * 而是累积起来每帧（约 16ms）通知一次，每帧只做一次布局，适用于日志等高频追加的场景。
+     * 配合 ListView::AnchorBottom 使用，视口位于底部时会跟随新内容。
+     * 调用前至少要有一个分组；调用其他修改接口之前会先通知累积的追加。
+     * 必须在 UI 线程调用。
+     */
+    void appendItems(size_t count);
+
+    /**
+     * 流式追加分组：子类在末尾追加了一个分组（可带有数据项）之后调用此函数，
+     * 此后 appendItems 追加的数据项都属于这个分组。
+     */
+    void appendGroup();
+
+    /**
+     * 设置保留上限。每次通知累积的追加之后，如果超出上限，就从头部丢弃最早的数据：
+     * 先丢弃多余的分组，再按数据项总数丢弃整个分组或第一个分组开头的数据项（最后一个分组只丢弃数据项），
+     * 通过 dropLeadingGroup / dropLeadingItems 由子类删除数据。
+     * 数据项总数在第一次丢弃时统计一次，之后随每次修改更新，不需要每帧遍历分组。
+     * 列表布局 (ListView::ListLayout) 中丢弃头部的数据不会移动其余数据项的高度缓存与位置索引，代价只与丢弃的数量有关。
+     * 网格与瀑布流布局中其余数据项的排列随之改变：网格布局丢弃整行（数目为列数的倍数）时只删除这些行，
+     * 否则与瀑布流布局一样需要重新排列该分组，代价与分组的数据项数目成正比。
+     * 这两种布局接收大量流式数据时，应让每个分组较小，或按分组数目 (maxGroups) 限制，丢弃整个分组的代价与其余分组无关。
+     * @param maxItems 数据项总数上限，0 表示不限制
+     * @param maxGroups 分组数目上限，0 表示不限制
+     */
+    void setRetentionLimit(int maxItems, int maxGroups = 0);
+
+    /**
+     * 设置是否合并 itemUpdated 。适用于同一批数据项每秒被更新成百上千次的场景（如行情列表）。
+     * 开启后 itemUpdated 只记录索引，同一数据项的多次更新只保留一次，与流式追加一样每帧（约 16ms）通知一次，
+     * 同一分组中连续的数据项合并为一个区间，整批只做一次布局；高度没有变化的数据项只重绘已加载的视图，不做布局。
+     * 调用其他修改接口、flushAppends 之前会先通知累积的更新；关闭时立即通知。
+     * 对隐藏或暂停的 ListView ，更新仍然只记录，直到恢复时才测量。
+     */
+    void setUpdateCoalescing(bool enabled);
+
+    /**
+     * 分页到达：子类在分组 group 的末尾追加了 count 个数据项之后调用此函数，此后可以再次请求该分组
+     * 与流式追加不同，新的一页立即通知 ListView ，只测量新增的数据项，滚动条的范围随之增长。
+     * count 可以为 0（例如只是 hasMoreItems 变为 false），此时 ListView 在下一次调整视图时才会再次请求。
+     * 必须在 UI 线程调用。
+     */
+    void itemsFetched(int group, size_t count);
+
+    /// 以下是跨线程提交修改的保护接口，可在任意线程调用。
+protected:
+    /**
+     * 从任意线程提交一次修改，不需要把每次修改都通过信号转发到 UI 线程。
+     * 修改记录进入无锁队列，UI 线程在下一次事件循环中按提交顺序批量执行：
+     * 对每条记录调用对应的 begin* ，在 UI 线程执行 apply 修改子类的数据，再调用对应的 end* ；
+     * 整批修改只在最后做一次布局与视图调整。
+     * apply 中只应修改子类自己的数据，不要调用本类的通知接口；apply 可以为空。
+     * 索引按提交顺序解释为执行时刻的索引。
+     * 数据模型被删除之前，应确保不会再有其他线程提交修改。
+     */
+    void postInsertItems(const ListIndex& insertIndex, size_t count, std::function<void()> apply);
+    void postRemoveItems(const ListIndex& removeIndex, size_t count, std::function<void()> apply);
+    void postInsertGroup(int groupIndex, std::function<void()> apply);
+    void postRemoveGroup(int groupIndex, std::function<void()> apply);
+    void postItemUpdated(const ListIndex& index, std::function<void()> apply);
+
+    /**
+     * 跨线程版本的 appendItems / appendGroup ，追加仍然按帧合并通知
+     */
+    void postAppendItems(size_t count, std::function<void()> apply);
+    void postAppendGroup(std::function<void()> apply);
+
+    /**
+     * 跨线程版本的 requireReload
+     */
+    void postReload(std::function<void()> apply);
+
 private:
+    void postMutation(int type, const ListIndex& index, size_t count, std::function<void()>&& apply);
+    void drainMutations();
+    void trimToRetention();
+    void scheduleFlush();
+    void flushUpdates();
+    void notifyItemsUpdated(const ListIndex& first, int count);
+    void removeLeadingGroups(int count);
+
+    friend class ListDataModelPriv;
     class ListDataModelPriv* priv;
 public:
     ListDataModelPriv *getPriv() const;
@@ -2,9 +2,47 @@
 #define LISTDATAMODEL_IMPL_HPP
 
 #include "listdatamodel.h"
+#include "listmutationqueue_p.h"
+#include "listheightstore_p.h"
+#include <list>
 #include <set>
 
 class ListViewPriv;
+class QObject;
+class QTimer;
+
+/**
+ * 数据模型的观察者
+ * 代理模型通过它监听源模型的修改，修改类通知在源模型的数据修改完成之后 (end*) 发出。
+ */
+class ListDataModelObserver
+{
+public:
+    virtual ~ListDataModelObserver();
+
+    /**
+     * 源模型即将修改数据 (begin*) ，此时数据尚未改变
+     */
+    virtual void modelAboutToChange() = 0;
+    virtual void modelReloaded() = 0;
+    virtual void modelItemUpdated(const ListIndex& index) = 0;
+
+    /**
+     * 区间更新，默认实现对每个数据项调用 modelItemUpdated
+     */
+    virtual void modelItemsUpdated(const ListIndex& first, int count);
+    virtual void modelItemsInserted(const ListIndex& index, int count) = 0;
+    virtual void modelItemsRemoved(const ListIndex& index, int count) = 0;
+    virtual void modelGroupInserted(int group) = 0;
+    virtual void modelGroupRemoved(int group) = 0;
+    virtual void modelBatchBegin() = 0;
+    virtual void modelBatchEnd() = 0;
+
+    /**
+     * 源模型正在被删除，观察者应放弃对它的引用
+     */
+    virtual void modelDestroyed() = 0;
+};
 
 class ListDataModelPriv
 {
@@ -14,6 +52,58 @@ public:
 
     ListDataModel* owner;
     std::set<ListViewPriv*> listViewPrivs;
+    std::set<ListDataModelObserver*> observers;
+
+    // begin* 记录的修改，end* 时通知观察者
+    ListMutation change;
+
+    /// 修改序号，每次通知视图修改数据 (begin* / itemUpdated / requireReload) 前递增
+    quint64 changeSerial = 1;
+    /// 可共享的高度缓存，heightCacheKey 为空的视图使用的缓存不在其中
+    std::list<ListHeightStore*> heightStores;
+
+    /// 流式追加：尚未通知 ListView 的、追加到已通知的最后一个分组中的数据项数目，以及追加的分组数目
+    size_t pendingItems = 0;
+    int pendingGroups = 0;
+    QTimer* flushTimer = nullptr;
+
+    /// 合并更新：尚未通知 ListView 的 itemUpdated ，与追加一起每帧通知一次
+    bool coalesceUpdates = false;
+    std::set<ListIndex> pendingUpdates;
+
+    int maxItems = 0;
+    int maxGroups = 0;
+    /// 已通知的数据项总数，-1 表示尚未统计；第一次按总数丢弃时统计，之后随每次修改更新
+    qint64 itemTotal = -1;
+
+    /// 分页加载：已请求下一页、尚未到达的分组
+    std::set<int> fetchingGroups;
+
+    /// 跨线程提交的修改，dispatcher 在构造数据模型的线程（UI 线程）中创建，用于把执行投递到该线程
+    ListMutationQueue mutations;
+    std::atomic<bool> drainScheduled{false};
+    QObject* dispatcher = nullptr;
+
+    /**
+     * 通知所有视图开始/结束一批修改，批内的修改只在结束时做一次布局
+     */
+    void beginBatch();
+    void endBatch();
+
+    void beginChange(ListMutation::Type type, const ListIndex& index, size_t count);
+    void endChange();
+
+    /**
+     * 分组还有更多数据项并且没有正在请求时，调用 fetchMoreItems 请求下一页
+     */
+    void requestMoreItems(int group);
+
+    /**
+     * 获取 key 、mode 、width 都相同的高度缓存，不存在时创建一个尚未测量的缓存
+     * key 为空时总是创建只属于调用者的缓存
+     */
+    ListHeightStore* acquireHeights(const QString& key, int mode, int width);
+    void releaseHeights(ListHeightStore* store);
 };
 
 #endif
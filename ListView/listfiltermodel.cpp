@@ -0,0 +1,438 @@
+#include "listfiltermodel_p.h"
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace
+{
+
+class ListFilterTask : public QRunnable
+{
+public:
+    ListFilterTask(const std::shared_ptr<ListFilterChunk>& chunk, const std::shared_ptr<ListFilterLink>& link, ListFilterModelPriv* owner)
+        : chunk(chunk), link(link), owner(owner)
+    {
+    }
+
+    void run() override
+    {
+        for (int item = chunk->first; item < chunk->last; item++)
+        {
+            if (chunk->cancelled.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            if (chunk->predicate(ListIndex(chunk->group, item)))
+            {
+                chunk->matches.push_back(item);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->running = false;
+        if (link->receiver && !chunk->cancelled.load())
+        {
+            // receiver 在过滤模型删除前置空，并且删除时会丢弃尚未执行的投递，因此 owner 在回调中总是有效的
+            auto chunk = this->chunk;
+            auto owner = this->owner;
+            QMetaObject::invokeMethod(link->receiver, [owner, chunk]{owner->chunkFinished(chunk);}, Qt::QueuedConnection);
+        }
+        link->finished.notify_all();
+    }
+
+private:
+    std::shared_ptr<ListFilterChunk> chunk;
+    std::shared_ptr<ListFilterLink> link;
+    ListFilterModelPriv* owner;
+};
+
+}
+
+ListFilterModel::ListFilterModel() : filterPriv(new ListFilterModelPriv)
+{
+    filterPriv->owner = this;
+    filterPriv->link = std::make_shared<ListFilterLink>();
+    filterPriv->link->receiver = new QObject();
+}
+
+ListFilterModel::~ListFilterModel()
+{
+    filterPriv->cancelInFlight();
+    if (filterPriv->source)
+    {
+        filterPriv->source->getPriv()->observers.erase(filterPriv);
+    }
+    QObject* receiver;
+    {
+        std::lock_guard<std::mutex> lock(filterPriv->link->mutex);
+        receiver = filterPriv->link->receiver;
+        filterPriv->link->receiver = nullptr;
+    }
+    delete receiver;
+    delete filterPriv;
+}
+
+void ListFilterModel::setSourceModel(ListDataModel *source)
+{
+    if (filterPriv->source == source)
+    {
+        return;
+    }
+
+    filterPriv->cancelInFlight();
+    if (filterPriv->source)
+    {
+        filterPriv->source->getPriv()->observers.erase(filterPriv);
+    }
+    filterPriv->source = source;
+    if (source)
+    {
+        source->getPriv()->observers.insert(filterPriv);
+    }
+    filterPriv->reset();
+}
+
+ListDataModel *ListFilterModel::sourceModel() const
+{
+    return filterPriv->source;
+}
+
+void ListFilterModel::setFilter(ListFilterModel::Predicate predicate)
+{
+    filterPriv->predicate = std::move(predicate);
+    filterPriv->reset();
+}
+
+bool ListFilterModel::isFiltering() const
+{
+    return filterPriv->inFlight != nullptr;
+}
+
+void ListFilterModel::setChunkSize(int size)
+{
+    filterPriv->chunkSize = std::max(1, size);
+}
+
+ListIndex ListFilterModel::mapToSource(const ListIndex &index) const
+{
+    if (index.isHeader())
+    {
+        return index;
+    }
+    return ListIndex(index.group, filterPriv->rows[index.group][index.item]);
+}
+
+ListIndex ListFilterModel::mapFromSource(const ListIndex &sourceIndex) const
+{
+    if (sourceIndex.isHeader())
+    {
+        return sourceIndex;
+    }
+    const auto& groupRows = filterPriv->rows[sourceIndex.group];
+    auto it = std::lower_bound(groupRows.begin(), groupRows.end(), sourceIndex.item);
+    if (it == groupRows.end() || *it != sourceIndex.item)
+    {
+        return ListIndex();
+    }
+    return ListIndex(sourceIndex.group, int(it - groupRows.begin()));
+}
+
+int ListFilterModel::numGroups()
+{
+    return (int)filterPriv->rows.size();
+}
+
+int ListFilterModel::numItemsInGroup(int group)
+{
+    return (int)filterPriv->rows[group].size();
+}
+
+void *ListFilterModel::dataForIndex(const ListIndex &index)
+{
+    return filterPriv->source ? filterPriv->source->data<void>(mapToSource(index)) : nullptr;
+}
+
+
+
+void ListFilterModelPriv::reset()
+{
+    cancelInFlight();
+    const auto nGroups = source ? source->numGroups() : 0;
+    rows.assign(nGroups, std::vector<int>());
+    cursorGroup = 0;
+    cursorItem = 0;
+    if (!predicate)
+    {
+        // 不过滤时直接建立一一对应的映射
+        for (int group = 0; group < nGroups; group++)
+        {
+            auto& groupRows = rows[group];
+            groupRows.resize(source->numItemsInGroup(group));
+            for (int item = 0; item < (int)groupRows.size(); item++)
+            {
+                groupRows[item] = item;
+            }
+        }
+        cursorGroup = nGroups;
+    }
+    owner->requireReload();
+    scheduleNext();
+}
+
+void ListFilterModelPriv::scheduleNext()
+{
+    if (inFlight || batchDepth > 0 || !predicate || !source)
+    {
+        return;
+    }
+
+    const auto nGroups = (int)rows.size();
+    while (cursorGroup < nGroups && cursorItem >= source->numItemsInGroup(cursorGroup))
+    {
+        cursorGroup++;
+        cursorItem = 0;
+    }
+    if (cursorGroup >= nGroups)
+    {
+        return;
+    }
+
+    auto chunk = std::make_shared<ListFilterChunk>();
+    chunk->predicate = predicate;
+    chunk->group = cursorGroup;
+    chunk->first = cursorItem;
+    chunk->last = std::min(source->numItemsInGroup(cursorGroup), cursorItem + chunkSize);
+    inFlight = chunk;
+    {
+        std::lock_guard<std::mutex> lock(link->mutex);
+        link->running = true;
+    }
+    QThreadPool::globalInstance()->start(new ListFilterTask(chunk, link, this));
+}
+
+void ListFilterModelPriv::chunkFinished(const std::shared_ptr<ListFilterChunk> &chunk)
+{
+    if (chunk != inFlight)
+    {
+        // 已被取消的块
+        return;
+    }
+    inFlight.reset();
+
+    // 源模型在块执行期间没有修改结构 (begin* 会取消正在执行的块)，匹配项都在已有结果之后
+    auto& groupRows = rows[chunk->group];
+    if (!chunk->matches.empty())
+    {
+        owner->beginInsertItems(ListIndex(chunk->group, (int)groupRows.size()), chunk->matches.size());
+        groupRows.insert(groupRows.end(), chunk->matches.begin(), chunk->matches.end());
+        owner->endInsertItems();
+    }
+    cursorItem = chunk->last;
+    scheduleNext();
+}
+
+void ListFilterModelPriv::cancelInFlight()
+{
+    if (!inFlight)
+    {
+        return;
+    }
+    inFlight->cancelled = true;
+    std::unique_lock<std::mutex> lock(link->mutex);
+    link->finished.wait(lock, [this]{return !link->running;});
+    inFlight.reset();
+}
+
+bool ListFilterModelPriv::isScanned(int group, int item) const
+{
+    return !predicate || group < cursorGroup || (group == cursorGroup && item < cursorItem);
+}
+
+bool ListFilterModelPriv::accepts(const ListIndex &sourceIndex) const
+{
+    return !predicate || predicate(sourceIndex);
+}
+
+void ListFilterModelPriv::modelAboutToChange()
+{
+    // 源模型即将修改数据，不能让工作线程继续读取；取消的块在修改完成后从 cursor 重新提交
+    cancelInFlight();
+}
+
+void ListFilterModelPriv::modelReloaded()
+{
+    reset();
+}
+
+void ListFilterModelPriv::modelItemUpdated(const ListIndex &index)
+{
+    if (index.isHeader())
+    {
+        owner->itemUpdated(index);
+        return;
+    }
+    if (!isScanned(index.group, index.item))
+    {
+        return;
+    }
+
+    auto& groupRows = rows[index.group];
+    auto it = std::lower_bound(groupRows.begin(), groupRows.end(), index.item);
+    const auto pos = int(it - groupRows.begin());
+    const auto present = it != groupRows.end() && *it == index.item;
+    const auto accepted = accepts(index);
+    if (accepted && present)
+    {
+        owner->itemUpdated(ListIndex(index.group, pos));
+    }
+    else if (accepted)
+    {
+        owner->beginInsertItems(ListIndex(index.group, pos), 1);
+        groupRows.insert(it, index.item);
+        owner->endInsertItems();
+    }
+    else if (present)
+    {
+        owner->beginRemoveItems(ListIndex(index.group, pos), 1);
+        groupRows.erase(it);
+        owner->endRemoveItems();
+    }
+}
+
+void ListFilterModelPriv::modelItemsUpdated(const ListIndex &first, int count)
+{
+    // 逐项映射到本模型，合并为一次布局
+    owner->getPriv()->beginBatch();
+    ListDataModelObserver::modelItemsUpdated(first, count);
+    owner->getPriv()->endBatch();
+}
+
+void ListFilterModelPriv::modelItemsInserted(const ListIndex &index, int count)
+{
+    const auto group = index.group;
+    const auto scanned = isScanned(group, index.item);
+    auto& groupRows = rows[group];
+    const auto pos = int(std::lower_bound(groupRows.begin(), groupRows.end(), index.item) - groupRows.begin());
+    for (auto it = groupRows.begin() + pos; it != groupRows.end(); it++)
+    {
+        *it += count;
+    }
+    if (group == cursorGroup && index.item < cursorItem)
+    {
+        cursorItem += count;
+    }
+
+    // 插入到已过滤的部分时只对新数据项求值，否则留给工作线程
+    if (scanned)
+    {
+        std::vector<int> matches;
+        for (int item = index.item; item < index.item + count; item++)
+        {
+            if (accepts(ListIndex(group, item)))
+            {
+                matches.push_back(item);
+            }
+        }
+        if (!matches.empty())
+        {
+            owner->beginInsertItems(ListIndex(group, pos), matches.size());
+            groupRows.insert(groupRows.begin() + pos, matches.begin(), matches.end());
+            owner->endInsertItems();
+        }
+    }
+    scheduleNext();
+}
+
+void ListFilterModelPriv::modelItemsRemoved(const ListIndex &index, int count)
+{
+    const auto group = index.group;
+    auto& groupRows = rows[group];
+    const auto first = int(std::lower_bound(groupRows.begin(), groupRows.end(), index.item) - groupRows.begin());
+    const auto last = int(std::lower_bound(groupRows.begin(), groupRows.end(), index.item + count) - groupRows.begin());
+    if (group == cursorGroup && cursorItem > index.item)
+    {
+        cursorItem = std::max(index.item, cursorItem - count);
+    }
+    // endRemoveItems 会立即重新布局并通过 mapToSource 读取数据，之后的行要先换算为删除后的位置
+    if (last > first)
+    {
+        owner->beginRemoveItems(ListIndex(group, first), last - first);
+    }
+    groupRows.erase(groupRows.begin() + first, groupRows.begin() + last);
+    for (auto it = groupRows.begin() + first; it != groupRows.end(); it++)
+    {
+        *it -= count;
+    }
+    if (last > first)
+    {
+        owner->endRemoveItems();
+    }
+    scheduleNext();
+}
+
+void ListFilterModelPriv::modelGroupInserted(int group)
+{
+    const auto beforeCursor = group < cursorGroup || (group == cursorGroup && cursorItem > 0);
+    std::vector<int> groupRows;
+    if (!predicate || beforeCursor)
+    {
+        const auto numItems = source->numItemsInGroup(group);
+        for (int item = 0; item < numItems; item++)
+        {
+            if (accepts(ListIndex(group, item)))
+            {
+                groupRows.push_back(item);
+            }
+        }
+    }
+
+    owner->beginInsertGroup(group);
+    rows.insert(rows.begin() + group, std::move(groupRows));
+    owner->endInsertGroup();
+
+    if (beforeCursor || !predicate)
+    {
+        cursorGroup++;
+    }
+    scheduleNext();
+}
+
+void ListFilterModelPriv::modelGroupRemoved(int group)
+{
+    owner->beginRemoveGroup(group);
+    rows.erase(rows.begin() + group);
+    owner->endRemoveGroup();
+
+    if (group < cursorGroup)
+    {
+        cursorGroup--;
+    }
+    else if (group == cursorGroup)
+    {
+        cursorItem = 0;
+    }
+    scheduleNext();
+}
+
+void ListFilterModelPriv::modelBatchBegin()
+{
+    batchDepth++;
+    owner->getPriv()->beginBatch();
+}
+
+void ListFilterModelPriv::modelBatchEnd()
+{
+    owner->getPriv()->endBatch();
+    if (--batchDepth == 0)
+    {
+        scheduleNext();
+    }
+}
+
+void ListFilterModelPriv::modelDestroyed()
+{
+    cancelInFlight();
+    source = nullptr;
+    reset();
+}
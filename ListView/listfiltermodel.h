@@ -0,0 +1,72 @@
+#ifndef LISTFILTERMODEL_H
+#define LISTFILTERMODEL_H
+
+#include "listdatamodel.h"
+#include <functional>
+
+/**
+ * 过滤代理模型
+ * 以另一个 ListDataModel 为源，只保留满足过滤条件的数据项，分组与源模型一一对应。
+ * 使用方法：
+ * 1. 创建对象并调用 setSourceModel 关联源模型
+ * 2. 把此对象设置给 ListView ，delegate 中的索引是本模型的索引，可用 mapToSource 换算为源模型的索引
+ * 3. 搜索文本改变时调用 setFilter
+ *
+ * 设置过滤条件后，在工作线程中按块对源模型的数据项求值，每完成一块就把匹配的数据项追加到结果中，
+ * 因此结果是逐步出现的；再次调用 setFilter 会取消尚未完成的过滤。
+ * 源模型的 begin* / end* 修改会被换算为本模型的修改，只对新增或更新的数据项求值，不会重新扫描。
+ *
+ * 注意：过滤条件会在工作线程中调用，只能读取可以并发读取的数据。
+ * 源模型的 begin* 会等待正在执行的块结束后才返回，因此通过 begin* / end* 进行的修改是安全的；
+ * 其他在通知之前修改数据的接口 (itemUpdated / appendItems 等) 要求被修改的数据本身可以并发读取。
+ */
+class ListFilterModel : public ListDataModel
+{
+public:
+    /**
+     * 过滤条件，参数为源模型的索引，返回 true 表示保留
+     */
+    typedef std::function<bool(const ListIndex& sourceIndex)> Predicate;
+
+    ListFilterModel();
+    ~ListFilterModel();
+
+    void setSourceModel(ListDataModel* source);
+    ListDataModel* sourceModel() const;
+
+    /**
+     * 设置过滤条件并重新过滤，传入空函数表示不过滤
+     */
+    void setFilter(Predicate predicate);
+
+    /**
+     * 是否还有尚未过滤的数据项
+     */
+    bool isFiltering() const;
+
+    /**
+     * 工作线程每次求值的数据项数目，默认为 16384
+     */
+    void setChunkSize(int size);
+
+    ListIndex mapToSource(const ListIndex& index) const;
+
+    /**
+     * 源模型索引对应的本模型索引，数据项被过滤掉或尚未过滤时返回空索引
+     */
+    ListIndex mapFromSource(const ListIndex& sourceIndex) const;
+
+    // ListDataModel interface
+public:
+    int numGroups() override;
+    int numItemsInGroup(int group) override;
+
+protected:
+    void* dataForIndex(const ListIndex& index) override;
+
+private:
+    friend class ListFilterModelPriv;
+    class ListFilterModelPriv* filterPriv;
+};
+
+#endif // LISTFILTERMODEL_H
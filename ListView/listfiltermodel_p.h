@@ -0,0 +1,90 @@
+#ifndef LISTFILTERMODEL_P_H
+#define LISTFILTERMODEL_P_H
+
+#include "listfiltermodel.h"
+#include "listdatamodel_p.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * 在工作线程中求值的一块数据项，范围为源模型中 group 分组的 [first, last)
+ */
+struct ListFilterChunk
+{
+    ListFilterModel::Predicate predicate;
+    int group = 0;
+    int first = 0;
+    int last = 0;
+    std::vector<int> matches;
+    std::atomic<bool> cancelled{false};
+};
+
+/**
+ * 工作线程与过滤模型之间的连接
+ * 过滤模型删除时把 receiver 置空，之后工作线程不会再投递结果；running 用于等待正在执行的块结束
+ */
+struct ListFilterLink
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool running = false;
+    QObject* receiver = nullptr;
+};
+
+class ListFilterModelPriv : public ListDataModelObserver
+{
+public:
+    ListFilterModel* owner;
+    ListDataModel* source = nullptr;
+    ListFilterModel::Predicate predicate;
+    int chunkSize = 16384;
+
+    // 每个分组中保留的源数据项索引，升序
+    std::deque<std::vector<int>> rows;
+
+    // 过滤进度，源模型中 cursor 之前的数据项都已经求值
+    int cursorGroup = 0;
+    int cursorItem = 0;
+
+    int batchDepth = 0;
+    std::shared_ptr<ListFilterChunk> inFlight;
+    std::shared_ptr<ListFilterLink> link;
+
+    /**
+     * 清空结果并从头开始过滤
+     */
+    void reset();
+
+    /**
+     * 没有正在执行的块时，从 cursor 开始提交下一块
+     */
+    void scheduleNext();
+    void chunkFinished(const std::shared_ptr<ListFilterChunk>& chunk);
+
+    /**
+     * 取消正在执行的块，并等待工作线程不再访问源模型
+     */
+    void cancelInFlight();
+
+    bool isScanned(int group, int item) const;
+    bool accepts(const ListIndex& sourceIndex) const;
+
+    // ListDataModelObserver interface
+public:
+    void modelAboutToChange() override;
+    void modelReloaded() override;
+    void modelItemUpdated(const ListIndex& index) override;
+    void modelItemsUpdated(const ListIndex& first, int count) override;
+    void modelItemsInserted(const ListIndex& index, int count) override;
+    void modelItemsRemoved(const ListIndex& index, int count) override;
+    void modelGroupInserted(int group) override;
+    void modelGroupRemoved(int group) override;
+    void modelBatchBegin() override;
+    void modelBatchEnd() override;
+    void modelDestroyed() override;
+};
+
+#endif // LISTFILTERMODEL_P_H
@@ -0,0 +1,125 @@
+#include "listgridlayout_p.h"
+#include "listviewdelegate.h"
+#include <algorithm>
+
+int ListGridLayout::itemWidth(int group) const
+{
+    return width() / columnsForGroup(group);
+}
+
+bool ListGridLayout::dependsOnWidth() const
+{
+    // 宽度改变可能改变列数
+    return true;
+}
+
+void ListGridLayout::clearGroups()
+{
+    groups.clear();
+}
+
+void ListGridLayout::insertGroupSlot(int group)
+{
+    groups.insert(groups.begin() + group, Group());
+}
+
+void ListGridLayout::removeGroupSlot(int group)
+{
+    groups.erase(groups.begin() + group);
+}
+
+int ListGridLayout::layoutGroup(int group, const ListHeights &itemHeights)
+{
+    auto& g = groups[group];
+    g.columns = columnsForGroup(group);
+    g.numItems = (int)itemHeights.size();
+
+    const int numRows = (g.numItems + g.columns - 1) / g.columns;
+    std::vector<int> rowHeights(numRows);
+    for (int row = 0; row < numRows; row++)
+    {
+        rowHeights[row] = rowHeight(g, row, itemHeights);
+    }
+    g.rows.assign(rowHeights);
+    return g.rows.total();
+}
+
+int ListGridLayout::layoutItemsInserted(int group, int first, int, const ListHeights &itemHeights)
+{
+    return relayoutRows(groups[group], first, itemHeights);
+}
+
+int ListGridLayout::layoutItemsRemoved(int group, int first, int count, const ListHeights &itemHeights)
+{
+    auto& g = groups[group];
+    if (first % g.columns == 0 && count % g.columns == 0)
+    {
+        // 删除的是整行，其余数据项所在的行不变，例如保留上限丢弃头部的整行
+        g.rows.erase(first / g.columns, count / g.columns);
+        g.numItems = (int)itemHeights.size();
+        return g.rows.total();
+    }
+    return relayoutRows(g, first, itemHeights);
+}
+
+int ListGridLayout::layoutItemsUpdated(int group, int first, int count, const ListHeights &itemHeights)
+{
+    auto& g = groups[group];
+    for (int row = first / g.columns; row <= (first + count - 1) / g.columns; row++)
+    {
+        g.rows.set(row, rowHeight(g, row, itemHeights));
+    }
+    return g.rows.total();
+}
+
+QRect ListGridLayout::groupItemRect(int group, int item) const
+{
+    const auto& g = groups[group];
+    const auto row = item / g.columns;
+    const auto column = item % g.columns;
+    const auto x = column * width() / g.columns;
+    const auto right = (column + 1) * width() / g.columns;
+    return QRect(x, g.rows.prefix(row), right - x, g.rows.height(row));
+}
+
+void ListGridLayout::groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex> &result) const
+{
+    const auto& g = groups[group];
+    auto row = g.rows.lowerBound(top);
+    auto y = g.rows.prefix(row);
+    for (; row < g.rows.size() && y <= bottom; row++)
+    {
+        const auto last = std::min(g.numItems, (row + 1) * g.columns);
+        for (auto item = row * g.columns; item < last; item++)
+        {
+            result.push_back(ListIndex(group, item));
+        }
+        y += g.rows.height(row);
+    }
+}
+
+int ListGridLayout::columnsForGroup(int group) const
+{
+    auto preferredWidth = delegate ? delegate->preferredItemWidth(group) : 0;
+    return preferredWidth > 0 ? std::max(1, width() / preferredWidth) : 1;
+}
+
+int ListGridLayout::relayoutRows(Group &g, int first, const ListHeights &itemHeights)
+{
+    const int firstRow = first / g.columns;
+    g.numItems = (int)itemHeights.size();
+    const int numRows = (g.numItems + g.columns - 1) / g.columns;
+    g.rows.erase(firstRow, g.rows.size() - firstRow);
+    for (int row = firstRow; row < numRows; row++)
+    {
+        g.rows.append(rowHeight(g, row, itemHeights));
+    }
+    return g.rows.total();
+}
+
+int ListGridLayout::rowHeight(const Group& g, int row, const ListHeights &itemHeights) const
+{
+    auto first = itemHeights.begin() + row * g.columns;
+    auto last = itemHeights.begin() + std::min(g.numItems, (row + 1) * g.columns);
+    return *std::max_element(first, last);
+}
@@ -0,0 +1,48 @@
+#ifndef LISTGRIDLAYOUT_P_H
+#define LISTGRIDLAYOUT_P_H
+
+#include "listlayoutengine_p.h"
+
+/**
+ * 网格布局
+ * 分组内每行最多 columns 个数据项，各列平分可用宽度，行高取该行数据项高度的最大值。
+ * 列数为 可用宽度 / ListViewDelegate::preferredItemWidth ，至少 1 列。
+ * 每个分组用一个高度索引保存行高，查询某个区间内的数据项时按行二分查找。
+ */
+class ListGridLayout : public ListLayoutEngine
+{
+public:
+    int itemWidth(int group) const override;
+    bool dependsOnWidth() const override;
+
+protected:
+    void clearGroups() override;
+    void insertGroupSlot(int group) override;
+    void removeGroupSlot(int group) override;
+    int layoutGroup(int group, const ListHeights& itemHeights) override;
+    int layoutItemsInserted(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsRemoved(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsUpdated(int group, int first, int count, const ListHeights& itemHeights) override;
+    QRect groupItemRect(int group, int item) const override;
+    void groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex>& result) const override;
+
+private:
+    struct Group
+    {
+        int columns = 1;
+        int numItems = 0;
+        ListHeightIndex rows;
+    };
+
+    int columnsForGroup(int group) const;
+
+    /**
+     * 插入或删除数据项后，first 所在行之后的数据项都会移动，重新计算这些行
+     */
+    int relayoutRows(Group& g, int first, const ListHeights& itemHeights);
+    int rowHeight(const Group& g, int row, const ListHeights& itemHeights) const;
+
+    std::deque<Group> groups;
+};
+
+#endif // LISTGRIDLAYOUT_P_H
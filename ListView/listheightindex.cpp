@@ -0,0 +1,212 @@
+#include "listheightindex_p.h"
+#include <algorithm>
+
+void ListHeightIndex::clear()
+{
+    cells.clear();
+    base = 0;
+    count = 0;
+    rebuild();
+}
+
+void ListHeightIndex::insert(int pos, int n, int height)
+{
+    makeRoom(pos, n);
+    for (int i = 0; i < n; i++)
+    {
+        setCell(base + pos + i, height);
+    }
+}
+
+void ListHeightIndex::insert(int pos, ListHeights::const_iterator first, ListHeights::const_iterator last)
+{
+    makeRoom(pos, int(last - first));
+    for (auto cell = base + pos; first != last; first++, cell++)
+    {
+        setCell(cell, *first);
+    }
+}
+
+void ListHeightIndex::erase(int pos, int n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+    if (pos < count - pos - n)
+    {
+        // 前面的元素较少，把它们向后移动，头部留下的位置不需要清零
+        for (int i = pos - 1; i >= 0; i--)
+        {
+            setCell(base + i + n, cells[base + i]);
+        }
+        base += n;
+        baseSum = cellPrefix(base);
+    }
+    else
+    {
+        for (int i = pos + n; i < count; i++)
+        {
+            setCell(base + i - n, cells[base + i]);
+        }
+        for (int i = count - n; i < count; i++)
+        {
+            setCell(base + i, 0);
+        }
+    }
+    count -= n;
+    totalHeight = cellPrefix(base + count) - baseSum;
+}
+
+void ListHeightIndex::append(int height)
+{
+    insert(count, 1, height);
+}
+
+void ListHeightIndex::set(int pos, int height)
+{
+    setCell(base + pos, height);
+}
+
+int ListHeightIndex::size() const
+{
+    return count;
+}
+
+int ListHeightIndex::height(int pos) const
+{
+    return cells[base + pos];
+}
+
+int ListHeightIndex::total() const
+{
+    return totalHeight;
+}
+
+int ListHeightIndex::prefix(int pos) const
+{
+    return cellPrefix(base + pos) - baseSum;
+}
+
+int ListHeightIndex::lowerBound(int y) const
+{
+    // 在所有位置中找到前缀和 < baseSum + y 的最长前缀，其后的第一个位置即为所求。
+    // base 之前的位置之和恰好为 baseSum ，base + count 之后的位置都是 0 ，结果只需截断到 [0, count]
+    const int n = (int)cells.size();
+    const int target = baseSum + y;
+    int step = 1;
+    while (step * 2 <= n)
+    {
+        step *= 2;
+    }
+    int cell = 0;
+    int sum = 0;
+    for (; step > 0; step /= 2)
+    {
+        if (cell + step <= n && sum + tree[cell + step] < target)
+        {
+            cell += step;
+            sum += tree[cell];
+        }
+    }
+    return std::min(count, std::max(0, cell - base));
+}
+
+void ListHeightIndex::makeRoom(int pos, int n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+    if (pos < count - pos)
+    {
+        // 前面的元素较少，把它们向前移动
+        reserve(n, 0);
+        for (int i = 0; i < pos; i++)
+        {
+            setCell(base + i - n, cells[base + i]);
+        }
+        base -= n;
+        baseSum = cellPrefix(base);
+        for (int i = pos; i < pos + n; i++)
+        {
+            setCell(base + i, 0);
+        }
+    }
+    else
+    {
+        reserve(0, n);
+        for (int i = count - 1; i >= pos; i--)
+        {
+            setCell(base + i + n, cells[base + i]);
+        }
+        for (int i = pos; i < pos + n; i++)
+        {
+            setCell(base + i, 0);
+        }
+    }
+    count += n;
+    totalHeight = cellPrefix(base + count) - baseSum;
+}
+
+void ListHeightIndex::reserve(int front, int back)
+{
+    const int backRoom = (int)cells.size() - base - count;
+    if (base >= front && backRoom >= back)
+    {
+        return;
+    }
+    // 空位不足时按元素数目成倍预留，需要空位的一端预留 max(需要的数目, count) 个，另一端保留原有的空位，但不超过 count 个
+    const int newFront = base >= front ? std::min(base, count) : std::max(front, count);
+    const int newBack = backRoom >= back ? std::min(backRoom, count) : std::max(back, count);
+    std::vector<int> newSlots(newFront + count + newBack, 0);
+    std::copy(cells.begin() + base, cells.begin() + base + count, newSlots.begin() + newFront);
+    cells.swap(newSlots);
+    base = newFront;
+    rebuild();
+}
+
+void ListHeightIndex::rebuild()
+{
+    const int n = (int)cells.size();
+    tree.assign(n + 1, 0);
+    for (int i = 1; i <= n; i++)
+    {
+        tree[i] += cells[i - 1];
+        const int parent = i + (i & -i);
+        if (parent <= n)
+        {
+            tree[parent] += tree[i];
+        }
+    }
+    baseSum = cellPrefix(base);
+    totalHeight = cellPrefix(base + count) - baseSum;
+}
+
+void ListHeightIndex::setCell(int cell, int height)
+{
+    const int dh = height - cells[cell];
+    if (dh == 0)
+    {
+        return;
+    }
+    cells[cell] = height;
+    if (cell >= base && cell < base + count)
+    {
+        totalHeight += dh;
+    }
+    for (int i = cell + 1; i < (int)tree.size(); i += i & -i)
+    {
+        tree[i] += dh;
+    }
+}
+
+int ListHeightIndex::cellPrefix(int cell) const
+{
+    int result = 0;
+    for (int i = cell; i > 0; i -= i & -i)
+    {
+        result += tree[i];
+    }
+    return result;
+}
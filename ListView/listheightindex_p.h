@@ -0,0 +1,87 @@
+#ifndef LISTHEIGHTINDEX_P_H
+#define LISTHEIGHTINDEX_P_H
+
+#include <deque>
+#include <vector>
+
+/**
+ * 一组数据项的高度
+ * 使用 deque 以便在头部插入（例如聊天记录向前加载）与删除时只移动被修改的元素
+ */
+typedef std::deque<int> ListHeights;
+
+/**
+ * 高度索引
+ * 保存一组连续排列的元素（数据项、网格的行、分组等）的高度，基于树状数组 (Fenwick tree) 实现：
+ * 修改单个元素的高度、查询前缀高度、按位置查找元素均为 O(log n) 。
+ * 元素存放在一段更大的空间中，前后都预留了空位：
+ * 在 pos 处插入或删除 k 个元素时，只移动 pos 与较近一端之间的元素，为 O((min(pos, n - pos) + k) log n) ，
+ * 因此在头部或尾部插入 k 个元素为 O(k log n) ，从头部删除元素为 O(log n) 。空位不足时整体重建，均摊开销不变。
+ */
+class ListHeightIndex
+{
+public:
+    void clear();
+
+    template<class Container>
+    void assign(const Container& heights)
+    {
+        cells.assign(heights.begin(), heights.end());
+        base = 0;
+        count = (int)cells.size();
+        rebuild();
+    }
+
+    void insert(int pos, int count, int height = 0);
+    void insert(int pos, ListHeights::const_iterator first, ListHeights::const_iterator last);
+    void erase(int pos, int count);
+    void append(int height);
+
+    void set(int pos, int height);
+
+    int size() const;
+    int height(int pos) const;
+
+    /**
+     * 所有元素的高度之和
+     */
+    int total() const;
+
+    /**
+     * 前 pos 个元素的高度之和，即第 pos 个元素的顶部位置
+     */
+    int prefix(int pos) const;
+
+    /**
+     * 第一个底部位置 >= y 的元素，不存在时返回 size()
+     * 即与 ListView 的可见性规则 (y + h >= top) 对应的第一个元素
+     */
+    int lowerBound(int y) const;
+
+private:
+    /**
+     * 在 pos 处腾出 n 个位置，新位置的值为 0
+     */
+    void makeRoom(int pos, int n);
+
+    /**
+     * 确保头部至少有 front 个空位，尾部至少有 back 个空位
+     */
+    void reserve(int front, int back);
+    void rebuild();
+
+    void setCell(int cell, int height);
+    int cellPrefix(int cell) const;
+
+    // 元素 i 存放在 cells[base + i] ，base 之前的位置可能残留已删除的元素，base + count 之后的位置总是 0
+    std::vector<int> cells;
+    // tree[i] 保存 cells[i - lowbit(i), i) 的和，下标从 1 开始
+    std::vector<int> tree = {0};
+    int base = 0;
+    int count = 0;
+    // cells[0, base) 的和
+    int baseSum = 0;
+    int totalHeight = 0;
+};
+
+#endif // LISTHEIGHTINDEX_P_H
@@ -0,0 +1,31 @@
+#ifndef LISTHEIGHTSTORE_P_H
+#define LISTHEIGHTSTORE_P_H
+
+#include "listheightindex_p.h"
+#include <QString>
+
+/**
+ * 数据项高度缓存
+ * 由数据模型管理，同一数据模型上 delegate 的 heightCacheKey 相同、测量宽度相同的 ListView 共享同一份。
+ * 每次修改数据模型时，只有第一个收到通知的视图测量并更新缓存 (serial 追上数据模型的修改序号)，
+ * 其余视图直接使用更新后的高度重建各自的布局。
+ */
+class ListHeightStore
+{
+public:
+    QString key;
+    // 高度受宽度影响时为测量时的布局方式与宽度，否则为 -1
+    int mode = -1;
+    int width = -1;
+
+    int refs = 0;
+    // 缓存对应的数据模型修改序号，0 表示尚未测量
+    quint64 serial = 0;
+    // serial 对应的修改是更新数据项时，更新前后是否有数据项的高度改变
+    bool updateChanged = true;
+
+    // 分组使用 deque ，以便流式追加时从头部丢弃旧分组
+    std::deque<ListHeights> itemHeights;
+};
+
+#endif // LISTHEIGHTSTORE_P_H
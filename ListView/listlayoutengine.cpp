@@ -0,0 +1,189 @@
+#include "listlayoutengine_p.h"
+
+ListLayoutEngine::~ListLayoutEngine()
+{
+}
+
+void ListLayoutEngine::setDelegate(ListViewDelegate *delegate)
+{
+    this->delegate = delegate;
+}
+
+void ListLayoutEngine::setWidth(int width)
+{
+    layoutWidth = width;
+}
+
+int ListLayoutEngine::width() const
+{
+    return layoutWidth;
+}
+
+int ListLayoutEngine::itemWidth(int) const
+{
+    return layoutWidth;
+}
+
+bool ListLayoutEngine::dependsOnWidth() const
+{
+    return false;
+}
+
+void ListLayoutEngine::clear()
+{
+    headerHeights.clear();
+    itemsHeights.clear();
+    collapsedGroups.clear();
+    groupHeights.clear();
+    clearGroups();
+}
+
+int ListLayoutEngine::groupCount() const
+{
+    return groupHeights.size();
+}
+
+int ListLayoutEngine::contentHeight() const
+{
+    return groupHeights.total();
+}
+
+int ListLayoutEngine::groupTop(int group) const
+{
+    return groupHeights.prefix(group);
+}
+
+int ListLayoutEngine::groupHeight(int group) const
+{
+    return groupHeights.height(group);
+}
+
+int ListLayoutEngine::headerHeight(int group) const
+{
+    return headerHeights[group];
+}
+
+void ListLayoutEngine::insertGroup(int group, int headerHeight, const ListHeights &itemHeights, bool collapsed)
+{
+    headerHeights.insert(headerHeights.begin() + group, headerHeight);
+    insertGroupSlot(group);
+    const auto itemsHeight = layoutGroup(group, itemHeights);
+    itemsHeights.insert(itemsHeights.begin() + group, itemsHeight);
+    collapsedGroups.insert(collapsedGroups.begin() + group, collapsed);
+    const auto height = headerHeight + (collapsed ? 0 : itemsHeight);
+    if (group == groupHeights.size())
+    {
+        // 加载时逐个追加分组，避免每次都重建高度索引
+        groupHeights.append(height);
+    }
+    else
+    {
+        groupHeights.insert(group, 1, height);
+    }
+}
+
+void ListLayoutEngine::removeGroup(int group)
+{
+    headerHeights.erase(headerHeights.begin() + group);
+    itemsHeights.erase(itemsHeights.begin() + group);
+    collapsedGroups.erase(collapsedGroups.begin() + group);
+    groupHeights.erase(group, 1);
+    removeGroupSlot(group);
+}
+
+void ListLayoutEngine::resetGroup(int group, int headerHeight, const ListHeights &itemHeights)
+{
+    setGroupHeight(group, headerHeight, layoutGroup(group, itemHeights));
+}
+
+void ListLayoutEngine::itemsInserted(int group, int first, int count, const ListHeights &itemHeights)
+{
+    setGroupHeight(group, headerHeights[group], layoutItemsInserted(group, first, count, itemHeights));
+}
+
+void ListLayoutEngine::itemsRemoved(int group, int first, int count, const ListHeights &itemHeights)
+{
+    setGroupHeight(group, headerHeights[group], layoutItemsRemoved(group, first, count, itemHeights));
+}
+
+void ListLayoutEngine::itemsUpdated(int group, int first, int count, const ListHeights &itemHeights)
+{
+    setGroupHeight(group, headerHeights[group], layoutItemsUpdated(group, first, count, itemHeights));
+}
+
+void ListLayoutEngine::setCollapsed(int group, bool collapsed)
+{
+    if (collapsedGroups[group] == collapsed)
+    {
+        return;
+    }
+    collapsedGroups[group] = collapsed;
+    groupHeights.set(group, headerHeights[group] + (collapsed ? 0 : itemsHeights[group]));
+}
+
+bool ListLayoutEngine::isCollapsed(int group) const
+{
+    return collapsedGroups[group];
+}
+
+QRect ListLayoutEngine::itemRect(const ListIndex &index) const
+{
+    const auto top = groupHeights.prefix(index.group);
+    const auto header = headerHeights[index.group];
+    if (index.isHeader())
+    {
+        return QRect(0, top, layoutWidth, header);
+    }
+    if (collapsedGroups[index.group])
+    {
+        return QRect(0, top + header, layoutWidth, 0);
+    }
+    return groupItemRect(index.group, index.item).translated(0, top + header);
+}
+
+void ListLayoutEngine::indexesInRange(int top, int bottom, std::vector<ListIndex> &result) const
+{
+    const auto nGroups = groupHeights.size();
+    auto group = groupHeights.lowerBound(top);
+    if (group == nGroups)
+    {
+        return;
+    }
+    auto groupTop = groupHeights.prefix(group);
+    for (; group < nGroups && groupTop <= bottom; group++)
+    {
+        const auto header = headerHeights[group];
+        if (groupTop + header >= top)
+        {
+            result.push_back(ListIndex(group));
+        }
+        if (!collapsedGroups[group])
+        {
+            const auto itemsTop = groupTop + header;
+            groupItemsInRange(group, top - itemsTop, bottom - itemsTop, result);
+        }
+        groupTop += groupHeights.height(group);
+    }
+}
+
+int ListLayoutEngine::layoutItemsInserted(int group, int, int, const ListHeights &itemHeights)
+{
+    return layoutGroup(group, itemHeights);
+}
+
+int ListLayoutEngine::layoutItemsRemoved(int group, int, int, const ListHeights &itemHeights)
+{
+    return layoutGroup(group, itemHeights);
+}
+
+int ListLayoutEngine::layoutItemsUpdated(int group, int, int, const ListHeights &itemHeights)
+{
+    return layoutGroup(group, itemHeights);
+}
+
+void ListLayoutEngine::setGroupHeight(int group, int headerHeight, int itemsHeight)
+{
+    headerHeights[group] = headerHeight;
+    itemsHeights[group] = itemsHeight;
+    groupHeights.set(group, headerHeight + (collapsedGroups[group] ? 0 : itemsHeight));
+}
@@ -0,0 +1,123 @@
+#ifndef LISTLAYOUTENGINE_P_H
+#define LISTLAYOUTENGINE_P_H
+
+#include "listdatamodel.h"
+#include "listheightindex_p.h"
+#include <QRect>
+#include <vector>
+
+class ListViewDelegate;
+
+/**
+ * 布局策略
+ * 把数据项索引映射为内容中的矩形，并回答某个纵向区间内有哪些分组头和数据项。
+ * 高度缓存、视图的加载与回收由 ListViewPriv 负责，布局策略只维护自己的位置索引。
+ *
+ * 分组自上而下依次排列，每个分组由一个占满整行的分组头（高度可以为 0）和若干数据项组成。
+ * 折叠的分组只占分组头的高度，其数据项的布局仍然保留并随修改更新，展开时不需要重新计算。
+ * 分组的顶部位置由本类维护，分组内数据项的排列由子类实现。
+ * 子类内部的坐标均相对于分组内第一个数据项的顶部。
+ */
+class ListLayoutEngine
+{
+public:
+    virtual ~ListLayoutEngine();
+
+    void setDelegate(ListViewDelegate* delegate);
+    void setWidth(int width);
+    int width() const;
+
+    /**
+     * 分组中数据项的可用宽度，即 heightForIndex 的 availableWidth 参数
+     */
+    virtual int itemWidth(int group) const;
+
+    /**
+     * 宽度改变时，即使数据项高度不变，是否也需要重新计算布局
+     */
+    virtual bool dependsOnWidth() const;
+
+    void clear();
+    int groupCount() const;
+    int contentHeight() const;
+    int groupTop(int group) const;
+    int groupHeight(int group) const;
+    int headerHeight(int group) const;
+
+    /**
+     * 在 group 处插入一个分组并计算其布局
+     * @param itemHeights 分组内所有数据项的高度
+     * @param collapsed 分组是否折叠
+     */
+    void insertGroup(int group, int headerHeight, const ListHeights& itemHeights, bool collapsed = false);
+    void removeGroup(int group);
+
+    /**
+     * 重新计算一个分组的布局
+     */
+    void resetGroup(int group, int headerHeight, const ListHeights& itemHeights);
+
+    /**
+     * 分组内的数据项发生变化，itemHeights 为变化之后分组内所有数据项的高度
+     */
+    void itemsInserted(int group, int first, int count, const ListHeights& itemHeights);
+    void itemsRemoved(int group, int first, int count, const ListHeights& itemHeights);
+    void itemsUpdated(int group, int first, int count, const ListHeights& itemHeights);
+
+    /**
+     * 折叠或展开分组，只修改分组的总高度，复杂度为 O(log n)
+     */
+    void setCollapsed(int group, bool collapsed);
+    bool isCollapsed(int group) const;
+
+    /**
+     * 折叠分组中的数据项返回分组头下方高度为 0 的矩形
+     */
+    QRect itemRect(const ListIndex& index) const;
+
+    /**
+     * 按索引顺序返回与 [top, bottom] 相交 (y <= bottom && y + h >= top) 的分组头和数据项
+     */
+    void indexesInRange(int top, int bottom, std::vector<ListIndex>& result) const;
+
+protected:
+    ListViewDelegate* delegate = nullptr;
+
+    /// 以下由子类实现，group 均为已存在的分组
+    virtual void clearGroups() = 0;
+    virtual void insertGroupSlot(int group) = 0;
+    virtual void removeGroupSlot(int group) = 0;
+
+    /**
+     * 计算分组内数据项的布局，返回数据项部分的总高度
+     */
+    virtual int layoutGroup(int group, const ListHeights& itemHeights) = 0;
+
+    /**
+     * 数据项变化后更新分组布局，返回数据项部分的总高度
+     * 默认实现调用 layoutGroup 重新计算整个分组
+     */
+    virtual int layoutItemsInserted(int group, int first, int count, const ListHeights& itemHeights);
+    virtual int layoutItemsRemoved(int group, int first, int count, const ListHeights& itemHeights);
+    virtual int layoutItemsUpdated(int group, int first, int count, const ListHeights& itemHeights);
+
+    virtual QRect groupItemRect(int group, int item) const = 0;
+
+    /**
+     * 按顺序追加分组内与 [top, bottom] 相交的数据项
+     */
+    virtual void groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex>& result) const = 0;
+
+private:
+    void setGroupHeight(int group, int headerHeight, int itemsHeight);
+
+    int layoutWidth = 0;
+    std::deque<int> headerHeights;
+    // 每个分组中数据项部分的高度，折叠时不计入分组的总高度
+    std::deque<int> itemsHeights;
+    std::deque<bool> collapsedGroups;
+    // 每个分组的总高度（分组头 + 未折叠时的数据项）
+    ListHeightIndex groupHeights;
+};
+
+#endif // LISTLAYOUTENGINE_P_H
@@ -0,0 +1,91 @@
+#include "listlayoutsnapshot_p.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(ListLayoutSnapshot::Header) % 8 == 0, "snapshot header must keep the arrays aligned");
+
+QByteArray ListLayoutSnapshot::encode(const std::deque<ListHeights> &itemHeights) const
+{
+    auto head = header;
+    head.magic = Magic;
+    head.version = FormatVersion;
+    head.groupCount = (qint32)itemHeights.size();
+    head.itemTotal = 0;
+    for (auto& groupItemHeights : itemHeights)
+    {
+        head.itemTotal += groupItemHeights.size();
+    }
+
+    QByteArray result;
+    result.resize(int(sizeof(Header) + (head.groupCount + head.itemTotal) * sizeof(qint32)));
+    auto out = result.data();
+    memcpy(out, &head, sizeof(Header));
+    auto counts = reinterpret_cast<qint32*>(out + sizeof(Header));
+    auto values = counts + head.groupCount;
+    for (auto& groupItemHeights : itemHeights)
+    {
+        *counts++ = (qint32)groupItemHeights.size();
+        values = std::copy(groupItemHeights.begin(), groupItemHeights.end(), values);
+    }
+    return result;
+}
+
+bool ListLayoutSnapshot::decode(const QByteArray &data)
+{
+    if ((size_t)data.size() < sizeof(Header))
+    {
+        return false;
+    }
+    memcpy(&header, data.constData(), sizeof(Header));
+    if (header.magic != Magic || header.version != FormatVersion || header.groupCount < 0 || header.itemTotal < 0)
+    {
+        return false;
+    }
+    // 数目来自文件，先用数据长度限制，损坏的文件不能使下面的长度计算溢出
+    const auto maxValues = qint64(((size_t)data.size() - sizeof(Header)) / sizeof(qint32));
+    if (header.groupCount > maxValues || header.itemTotal > maxValues - header.groupCount)
+    {
+        return false;
+    }
+    if ((size_t)data.size() != sizeof(Header) + size_t(header.groupCount + header.itemTotal) * sizeof(qint32))
+    {
+        return false;
+    }
+
+    this->data = data;
+    itemCounts = reinterpret_cast<const qint32*>(this->data.constData() + sizeof(Header));
+    heights = itemCounts + header.groupCount;
+
+    qint64 total = 0;
+    for (int group = 0; group < header.groupCount; group++)
+    {
+        if (itemCounts[group] < 0)
+        {
+            return false;
+        }
+        total += itemCounts[group];
+    }
+    return total == header.itemTotal;
+}
+
+int ListLayoutSnapshot::itemCount(int group) const
+{
+    return itemCounts[group];
+}
+
+bool ListLayoutSnapshot::fillHeights(std::deque<ListHeights> &itemHeights) const
+{
+    itemHeights.resize(header.groupCount);
+    auto values = heights;
+    for (int group = 0; group < header.groupCount; group++)
+    {
+        const auto end = values + itemCounts[group];
+        if (std::any_of(values, end, [](qint32 height){return height < 0;}))
+        {
+            return false;
+        }
+        itemHeights[group].assign(values, end);
+        values = end;
+    }
+    return true;
+}
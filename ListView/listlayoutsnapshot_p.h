@@ -0,0 +1,66 @@
+#ifndef LISTLAYOUTSNAPSHOT_P_H
+#define LISTLAYOUTSNAPSHOT_P_H
+
+#include "listheightindex_p.h"
+#include "listdatamodel.h"
+#include <QByteArray>
+
+/**
+ * 布局快照
+ * 保存数据项高度表与滚动锚点，用于下次启动时跳过测量直接恢复到上次的位置。
+ * 二进制格式（本机字节序）：
+ *   Header
+ *   qint32 itemCounts[groupCount]   每个分组的数据项数目
+ *   qint32 heights[itemTotal]       按分组依次排列的数据项高度
+ * Header 的长度是 8 的倍数，数组都是对齐的，可以直接对 QFile::map 映射的内存使用 QByteArray::fromRawData 读取。
+ */
+class ListLayoutSnapshot
+{
+public:
+    static const quint32 Magic = 0x4e53564c; // "LVSN"
+    static const quint32 FormatVersion = 1;
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint64 contentVersion;
+        // delegate 的 heightCacheKey 的哈希
+        quint32 keyHash;
+        // 高度受宽度影响时为保存时的布局方式与宽度，否则为 -1
+        qint32 mode;
+        qint32 width;
+        qint32 groupCount;
+        qint64 itemTotal;
+        qint32 anchorGroup;
+        qint32 anchorItem;
+        qint32 anchorDistance;
+        quint8 anchorFromBottom;
+        quint8 anchorBottom;
+        quint8 reserved[2];
+    };
+
+    Header header;
+
+    QByteArray encode(const std::deque<ListHeights>& itemHeights) const;
+
+    /**
+     * 解析快照并校验长度，成功后 itemCount / heights 指向 data 中的数据
+     */
+    bool decode(const QByteArray& data);
+
+    int itemCount(int group) const;
+
+    /**
+     * 按顺序把所有分组的高度写入 itemHeights
+     * @return 快照中有负的高度时返回 false ，此时 itemHeights 只写入了一部分，应重新测量
+     */
+    bool fillHeights(std::deque<ListHeights>& itemHeights) const;
+
+private:
+    QByteArray data;
+    const qint32* itemCounts = nullptr;
+    const qint32* heights = nullptr;
+};
+
+#endif // LISTLAYOUTSNAPSHOT_P_H
@@ -0,0 +1,130 @@
+#include "listmasonrylayout_p.h"
+#include "listviewdelegate.h"
+#include <algorithm>
+
+int ListMasonryLayout::itemWidth(int group) const
+{
+    return width() / columnsForGroup(group);
+}
+
+bool ListMasonryLayout::dependsOnWidth() const
+{
+    // 宽度改变可能改变列数
+    return true;
+}
+
+void ListMasonryLayout::clearGroups()
+{
+    groups.clear();
+}
+
+void ListMasonryLayout::insertGroupSlot(int group)
+{
+    groups.insert(groups.begin() + group, Group());
+}
+
+void ListMasonryLayout::removeGroupSlot(int group)
+{
+    groups.erase(groups.begin() + group);
+}
+
+int ListMasonryLayout::layoutGroup(int group, const ListHeights &itemHeights)
+{
+    auto& g = groups[group];
+    g.columns = columnsForGroup(group);
+    g.items.clear();
+    g.columnItems.assign(g.columns, std::vector<int>());
+    return placeItems(g, 0, itemHeights);
+}
+
+int ListMasonryLayout::layoutItemsInserted(int group, int first, int, const ListHeights &itemHeights)
+{
+    // 在末尾追加时 first 等于原数据项数目，只会放置新增的数据项
+    return placeItems(groups[group], first, itemHeights);
+}
+
+int ListMasonryLayout::layoutItemsRemoved(int group, int first, int, const ListHeights &itemHeights)
+{
+    return placeItems(groups[group], first, itemHeights);
+}
+
+int ListMasonryLayout::layoutItemsUpdated(int group, int first, int, const ListHeights &itemHeights)
+{
+    return placeItems(groups[group], first, itemHeights);
+}
+
+QRect ListMasonryLayout::groupItemRect(int group, int item) const
+{
+    const auto& g = groups[group];
+    const auto& it = g.items[item];
+    const auto x = it.column * width() / g.columns;
+    const auto right = (it.column + 1) * width() / g.columns;
+    return QRect(x, it.top, right - x, it.height);
+}
+
+void ListMasonryLayout::groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex> &result) const
+{
+    const auto& g = groups[group];
+    const auto begin = result.size();
+    for (auto& column : g.columnItems)
+    {
+        // 同一列中的数据项首尾相接，底部位置单调递增
+        auto it = std::partition_point(column.begin(), column.end(), [&](int item)
+        {
+            return g.items[item].top + g.items[item].height < top;
+        });
+        for (; it != column.end() && g.items[*it].top <= bottom; it++)
+        {
+            result.push_back(ListIndex(group, *it));
+        }
+    }
+    std::sort(result.begin() + begin, result.end());
+}
+
+int ListMasonryLayout::columnsForGroup(int group) const
+{
+    auto preferredWidth = delegate ? delegate->preferredItemWidth(group) : 0;
+    return preferredWidth > 0 ? std::max(1, width() / preferredWidth) : 1;
+}
+
+int ListMasonryLayout::placeItems(Group &g, int first, const ListHeights &itemHeights)
+{
+    // 去掉 first 及之后的数据项，它们总是在各列的末尾
+    g.items.resize(first);
+    for (auto& column : g.columnItems)
+    {
+        while (!column.empty() && column.back() >= first)
+        {
+            column.pop_back();
+        }
+    }
+
+    std::vector<int> bottoms(g.columns);
+    for (int column = 0; column < g.columns; column++)
+    {
+        bottoms[column] = columnBottom(g, column);
+    }
+
+    const auto numItems = (int)itemHeights.size();
+    g.items.reserve(numItems);
+    for (int item = first; item < numItems; item++)
+    {
+        // 放入最短的一列，高度相同时取靠左的一列
+        const auto column = int(std::min_element(bottoms.begin(), bottoms.end()) - bottoms.begin());
+        g.items.push_back({column, bottoms[column], itemHeights[item]});
+        g.columnItems[column].push_back(item);
+        bottoms[column] += itemHeights[item];
+    }
+    return bottoms.empty() ? 0 : *std::max_element(bottoms.begin(), bottoms.end());
+}
+
+int ListMasonryLayout::columnBottom(const Group &g, int column) const
+{
+    const auto& items = g.columnItems[column];
+    if (items.empty())
+    {
+        return 0;
+    }
+    const auto& last = g.items[items.back()];
+    return last.top + last.height;
+}
@@ -0,0 +1,57 @@
+#ifndef LISTMASONRYLAYOUT_P_H
+#define LISTMASONRYLAYOUT_P_H
+
+#include "listlayoutengine_p.h"
+
+/**
+ * 瀑布流布局
+ * 分组内的数据项按顺序依次放入当前最短的一列，列数的计算方式与网格布局相同。
+ * 每列按从上到下的顺序记录其中的数据项，查询区间时在每列中二分查找。
+ * 一个数据项的位置只依赖它之前的数据项，因此在分组末尾追加数据项时只需放置新增的数据项；
+ * 在中间插入、删除或更新时，从变化的位置开始重新放置。
+ */
+class ListMasonryLayout : public ListLayoutEngine
+{
+public:
+    int itemWidth(int group) const override;
+    bool dependsOnWidth() const override;
+
+protected:
+    void clearGroups() override;
+    void insertGroupSlot(int group) override;
+    void removeGroupSlot(int group) override;
+    int layoutGroup(int group, const ListHeights& itemHeights) override;
+    int layoutItemsInserted(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsRemoved(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsUpdated(int group, int first, int count, const ListHeights& itemHeights) override;
+    QRect groupItemRect(int group, int item) const override;
+    void groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex>& result) const override;
+
+private:
+    struct Item
+    {
+        int column;
+        int top;
+        int height;
+    };
+
+    struct Group
+    {
+        int columns = 1;
+        std::vector<Item> items;
+        // 每列中的数据项，按从上到下的顺序
+        std::vector<std::vector<int>> columnItems;
+    };
+
+    int columnsForGroup(int group) const;
+
+    /**
+     * 保留 first 之前的数据项，从 first 开始重新放置，返回分组内数据项部分的高度
+     */
+    int placeItems(Group& g, int first, const ListHeights& itemHeights);
+    int columnBottom(const Group& g, int column) const;
+
+    std::deque<Group> groups;
+};
+
+#endif // LISTMASONRYLAYOUT_P_H
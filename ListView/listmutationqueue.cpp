@@ -0,0 +1,38 @@
+#include "listmutationqueue_p.h"
+
+ListMutationQueue::ListMutationQueue()
+{
+    tail = new Node;
+    head.store(tail, std::memory_order_relaxed);
+}
+
+ListMutationQueue::~ListMutationQueue()
+{
+    ListMutation mutation;
+    while (pop(mutation))
+    {
+    }
+    delete tail;
+}
+
+void ListMutationQueue::push(ListMutation &&mutation)
+{
+    auto node = new Node;
+    node->value = std::move(mutation);
+    auto prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+bool ListMutationQueue::pop(ListMutation &mutation)
+{
+    auto next = tail->next.load(std::memory_order_acquire);
+    if (!next)
+    {
+        return false;
+    }
+    mutation = std::move(next->value);
+    next->value = ListMutation();
+    delete tail;
+    tail = next;
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef LISTMUTATIONQUEUE_P_H
+#define LISTMUTATIONQUEUE_P_H
+
+#include "listdatamodel.h"
+#include <atomic>
+#include <functional>
+
+/**
+ * 数据模型修改记录
+ * apply 在 UI 线程执行，由子类修改自己的数据；index 与 count 的含义与 begin* 系列接口相同，
+ * 按提交顺序解释为执行时刻的索引。
+ */
+struct ListMutation
+{
+    enum Type
+    {
+        InsertItems,
+        RemoveItems,
+        InsertGroup,
+        RemoveGroup,
+        UpdateItem,
+        AppendItems,
+        AppendGroup,
+        Reload
+    };
+
+    Type type = Reload;
+    ListIndex index;
+    size_t count = 0;
+    std::function<void()> apply;
+};
+
+/**
+ * 多生产者单消费者的无锁队列
+ * push 可在任意线程调用，只有一次原子交换；pop 只能在消费线程（UI 线程）调用。
+ * 生产者交换了头指针但尚未链接时，pop 会暂时认为队列为空，这条记录在下一次 pop 时取出。
+ */
+class ListMutationQueue
+{
+public:
+    ListMutationQueue();
+    ~ListMutationQueue();
+
+    void push(ListMutation&& mutation);
+    bool pop(ListMutation& mutation);
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        ListMutation value;
+    };
+
+    // 生产者在 head 追加，消费者从 tail 取出；tail 总是一个已取出的（或初始的）空节点
+    std::atomic<Node*> head;
+    Node* tail;
+};
+
+#endif // LISTMUTATIONQUEUE_P_H
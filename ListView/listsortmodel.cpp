@@ -0,0 +1,528 @@
+#include "listsortmodel_p.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+
+// 每个线程至少排序的数据项数目，数据项较少时线程的开销大于收益
+const int ListSortMinChunk = 8192;
+
+// 区间更新后需要移动的区间不超过更新项数目的这一倍数时，整段删除再插入，否则逐项移动
+const int ListSortSpanFactor = 4;
+
+template<class Less>
+void parallelSort(std::vector<int>& values, const Less& less)
+{
+    const auto size = (int)values.size();
+    const auto threads = std::max(1, (int)std::thread::hardware_concurrency());
+    const auto parts = std::min(threads, size / ListSortMinChunk);
+    if (parts <= 1)
+    {
+        std::sort(values.begin(), values.end(), less);
+        return;
+    }
+
+    std::vector<int> bounds(parts + 1);
+    for (int i = 0; i <= parts; i++)
+    {
+        bounds[i] = int((long long)size * i / parts);
+    }
+
+    // 各段在工作线程中排序，第一段在当前线程中排序
+    std::vector<std::thread> workers;
+    for (int i = 1; i < parts; i++)
+    {
+        workers.emplace_back([&values, &bounds, &less, i]{
+            std::sort(values.begin() + bounds[i], values.begin() + bounds[i + 1], less);
+        });
+    }
+    std::sort(values.begin(), values.begin() + bounds[1], less);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    // 两两归并，每一轮中的归并互不重叠，同样并行执行
+    for (int step = 1; step < parts; step *= 2)
+    {
+        workers.clear();
+        for (int i = 0; i + step < parts; i += step * 2)
+        {
+            const auto first = bounds[i];
+            const auto middle = bounds[i + step];
+            const auto last = bounds[std::min(parts, i + step * 2)];
+            workers.emplace_back([&values, &less, first, middle, last]{
+                std::inplace_merge(values.begin() + first, values.begin() + middle, values.begin() + last, less);
+            });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+}
+
+ListSortModel::ListSortModel() : sortPriv(new ListSortModelPriv)
+{
+    sortPriv->owner = this;
+}
+
+ListSortModel::~ListSortModel()
+{
+    if (sortPriv->source)
+    {
+        sortPriv->source->getPriv()->observers.erase(sortPriv);
+    }
+    delete sortPriv;
+}
+
+void ListSortModel::setSourceModel(ListDataModel *source)
+{
+    if (sortPriv->source == source)
+    {
+        return;
+    }
+
+    if (sortPriv->source)
+    {
+        sortPriv->source->getPriv()->observers.erase(sortPriv);
+    }
+    sortPriv->source = source;
+    if (source)
+    {
+        source->getPriv()->observers.insert(sortPriv);
+    }
+    sortPriv->reset();
+}
+
+ListDataModel *ListSortModel::sourceModel() const
+{
+    return sortPriv->source;
+}
+
+void ListSortModel::setSortOrder(ListSortModel::ItemLess itemLess, ListSortModel::GroupLess groupLess)
+{
+    sortPriv->itemLess = std::move(itemLess);
+    sortPriv->groupLess = std::move(groupLess);
+    sortPriv->reset();
+}
+
+ListIndex ListSortModel::mapToSource(const ListIndex &index) const
+{
+    if (index.isHeader())
+    {
+        return ListIndex(sortPriv->groupOrder[index.group]);
+    }
+    return ListIndex(sortPriv->groupOrder[index.group], sortPriv->rows[index.group][index.item]);
+}
+
+ListIndex ListSortModel::mapFromSource(const ListIndex &sourceIndex) const
+{
+    const auto group = sortPriv->proxyGroup(sourceIndex.group);
+    if (group < 0 || sourceIndex.isHeader())
+    {
+        return group < 0 ? ListIndex() : ListIndex(group);
+    }
+    const auto& groupRows = sortPriv->rows[group];
+    auto it = std::find(groupRows.begin(), groupRows.end(), sourceIndex.item);
+    if (it == groupRows.end())
+    {
+        return ListIndex();
+    }
+    return ListIndex(group, int(it - groupRows.begin()));
+}
+
+int ListSortModel::numGroups()
+{
+    return (int)sortPriv->rows.size();
+}
+
+int ListSortModel::numItemsInGroup(int group)
+{
+    return (int)sortPriv->rows[group].size();
+}
+
+void *ListSortModel::dataForIndex(const ListIndex &index)
+{
+    return sortPriv->source ? sortPriv->source->data<void>(mapToSource(index)) : nullptr;
+}
+
+
+
+void ListSortModelPriv::reset()
+{
+    const auto nGroups = source ? source->numGroups() : 0;
+    groupOrder.resize(nGroups);
+    for (int group = 0; group < nGroups; group++)
+    {
+        groupOrder[group] = group;
+    }
+    if (groupLess)
+    {
+        std::sort(groupOrder.begin(), groupOrder.end(), [this](int a, int b){return groupBefore(a, b);});
+    }
+
+    rows.assign(nGroups, std::vector<int>());
+    for (int group = 0; group < nGroups; group++)
+    {
+        rows[group] = sortedRows(groupOrder[group]);
+    }
+    owner->requireReload();
+}
+
+std::vector<int> ListSortModelPriv::sortedRows(int sourceGroup) const
+{
+    std::vector<int> groupRows(source->numItemsInGroup(sourceGroup));
+    for (int item = 0; item < (int)groupRows.size(); item++)
+    {
+        groupRows[item] = item;
+    }
+    if (itemLess)
+    {
+        parallelSort(groupRows, [this, sourceGroup](int a, int b){return itemBefore(sourceGroup, a, b);});
+    }
+    return groupRows;
+}
+
+bool ListSortModelPriv::itemBefore(int sourceGroup, int a, int b) const
+{
+    if (itemLess)
+    {
+        const ListIndex indexA(sourceGroup, a);
+        const ListIndex indexB(sourceGroup, b);
+        if (itemLess(indexA, indexB))
+        {
+            return true;
+        }
+        if (itemLess(indexB, indexA))
+        {
+            return false;
+        }
+    }
+    return a < b;
+}
+
+bool ListSortModelPriv::groupBefore(int a, int b) const
+{
+    if (groupLess)
+    {
+        if (groupLess(a, b))
+        {
+            return true;
+        }
+        if (groupLess(b, a))
+        {
+            return false;
+        }
+    }
+    return a < b;
+}
+
+int ListSortModelPriv::proxyGroup(int sourceGroup) const
+{
+    auto it = std::find(groupOrder.begin(), groupOrder.end(), sourceGroup);
+    return it == groupOrder.end() ? -1 : int(it - groupOrder.begin());
+}
+
+int ListSortModelPriv::insertPosition(int sourceGroup, const std::vector<int> &groupRows, int item) const
+{
+    auto it = std::lower_bound(groupRows.begin(), groupRows.end(), item, [this, sourceGroup](int a, int b){
+        return itemBefore(sourceGroup, a, b);
+    });
+    return int(it - groupRows.begin());
+}
+
+int ListSortModelPriv::groupInsertPosition(int sourceGroup) const
+{
+    auto it = std::lower_bound(groupOrder.begin(), groupOrder.end(), sourceGroup, [this](int a, int b){
+        return groupBefore(a, b);
+    });
+    return int(it - groupOrder.begin());
+}
+
+void ListSortModelPriv::modelAboutToChange()
+{
+}
+
+void ListSortModelPriv::modelReloaded()
+{
+    reset();
+}
+
+void ListSortModelPriv::modelItemUpdated(const ListIndex &index)
+{
+    const auto group = proxyGroup(index.group);
+    if (index.isHeader())
+    {
+        // 分组排序可能依赖标题数据，顺序改变时移动整个分组
+        const auto count = (int)groupOrder.size();
+        const auto misplaced = groupLess
+                && ((group > 0 && groupBefore(index.group, groupOrder[group - 1]))
+                    || (group + 1 < count && groupBefore(groupOrder[group + 1], index.group)));
+        if (!misplaced)
+        {
+            owner->itemUpdated(ListIndex(group));
+            return;
+        }
+
+        owner->getPriv()->beginBatch();
+        owner->beginRemoveGroup(group);
+        auto groupRows = std::move(rows[group]);
+        rows.erase(rows.begin() + group);
+        groupOrder.erase(groupOrder.begin() + group);
+        owner->endRemoveGroup();
+
+        const auto pos = groupInsertPosition(index.group);
+        owner->beginInsertGroup(pos);
+        groupOrder.insert(groupOrder.begin() + pos, index.group);
+        rows.insert(rows.begin() + pos, std::move(groupRows));
+        owner->endInsertGroup();
+        owner->getPriv()->endBatch();
+        return;
+    }
+
+    auto& groupRows = rows[group];
+    const auto pos = int(std::find(groupRows.begin(), groupRows.end(), index.item) - groupRows.begin());
+    const auto count = (int)groupRows.size();
+    const auto misplaced = (pos > 0 && itemBefore(index.group, index.item, groupRows[pos - 1]))
+            || (pos + 1 < count && itemBefore(index.group, groupRows[pos + 1], index.item));
+    if (!misplaced)
+    {
+        owner->itemUpdated(ListIndex(group, pos));
+        return;
+    }
+
+    // ListView 没有移动通知，在同一批修改中删除再插入，只做一次布局
+    owner->getPriv()->beginBatch();
+    owner->beginRemoveItems(ListIndex(group, pos), 1);
+    groupRows.erase(groupRows.begin() + pos);
+    owner->endRemoveItems();
+
+    const auto target = insertPosition(index.group, groupRows, index.item);
+    owner->beginInsertItems(ListIndex(group, target), 1);
+    groupRows.insert(groupRows.begin() + target, index.item);
+    owner->endInsertItems();
+    owner->getPriv()->endBatch();
+}
+
+void ListSortModelPriv::modelItemsUpdated(const ListIndex &first, int count)
+{
+    if (first.isHeader() || count == 1)
+    {
+        modelItemUpdated(first);
+        return;
+    }
+
+    const auto group = proxyGroup(first.group);
+    auto& groupRows = rows[group];
+    const auto last = first.item + count;
+    auto updated = [first, last](int item){return item >= first.item && item < last;};
+
+    // 一次遍历找出所有更新项的位置，只需比较它们与相邻项的顺序：两侧都没有更新的相邻项顺序不变
+    std::vector<int> positions;
+    positions.reserve(count);
+    bool misplaced = false;
+    for (int pos = 0; pos < (int)groupRows.size(); pos++)
+    {
+        if (updated(groupRows[pos]))
+        {
+            positions.push_back(pos);
+            misplaced = misplaced
+                    || (pos > 0 && itemBefore(first.group, groupRows[pos], groupRows[pos - 1]))
+                    || (pos + 1 < (int)groupRows.size() && itemBefore(first.group, groupRows[pos + 1], groupRows[pos]));
+        }
+    }
+
+    owner->getPriv()->beginBatch();
+    if (!misplaced)
+    {
+        for (size_t i = 0; i < positions.size(); )
+        {
+            auto n = size_t(1);
+            while (i + n < positions.size() && positions[i + n] == positions[i] + (int)n)
+            {
+                n++;
+            }
+            owner->itemsUpdated(ListIndex(group, positions[i]), n);
+            i += n;
+        }
+        owner->getPriv()->endBatch();
+        return;
+    }
+
+    // 先把更新项全部取出，其余数据项仍然有序，再与排好序的更新项归并得到新的顺序。
+    // 不能逐项二分插入：其余更新项还在旧位置上时数组并不有序。
+    std::vector<int> moved;
+    moved.reserve(positions.size());
+    std::vector<int> kept;
+    kept.reserve(groupRows.size() - positions.size());
+    for (auto item : groupRows)
+    {
+        (updated(item) ? moved : kept).push_back(item);
+    }
+    auto less = [this, &first](int a, int b){return itemBefore(first.group, a, b);};
+    std::sort(moved.begin(), moved.end(), less);
+    std::vector<int> sorted(groupRows.size());
+    std::merge(kept.begin(), kept.end(), moved.begin(), moved.end(), sorted.begin(), less);
+
+    // 新旧顺序不同的最小区间
+    auto lo = 0;
+    while (groupRows[lo] == sorted[lo])
+    {
+        lo++;
+    }
+    auto hi = (int)sorted.size() - 1;
+    while (groupRows[hi] == sorted[hi])
+    {
+        hi--;
+    }
+
+    if (hi - lo + 1 <= (int)moved.size() * ListSortSpanFactor)
+    {
+        // 区间不比更新项多太多：整段删除再插入，只有两次通知
+        // 不在区间内的更新项位置不变，按更新通知
+        for (auto pos : positions)
+        {
+            if (pos < lo || pos > hi)
+            {
+                owner->itemUpdated(ListIndex(group, pos));
+            }
+        }
+        owner->beginRemoveItems(ListIndex(group, lo), hi - lo + 1);
+        groupRows.erase(groupRows.begin() + lo, groupRows.begin() + hi + 1);
+        owner->endRemoveItems();
+        owner->beginInsertItems(ListIndex(group, lo), hi - lo + 1);
+        groupRows.insert(groupRows.begin() + lo, sorted.begin() + lo, sorted.begin() + hi + 1);
+        owner->endInsertItems();
+    }
+    else
+    {
+        // 更新项分散在很大的区间中：逐个从后往前删除，再按新顺序从前往后插入到最终位置
+        for (auto it = positions.rbegin(); it != positions.rend(); it++)
+        {
+            owner->beginRemoveItems(ListIndex(group, *it), 1);
+            groupRows.erase(groupRows.begin() + *it);
+            owner->endRemoveItems();
+        }
+        for (int pos = 0; pos < (int)sorted.size(); pos++)
+        {
+            if (updated(sorted[pos]))
+            {
+                owner->beginInsertItems(ListIndex(group, pos), 1);
+                groupRows.insert(groupRows.begin() + pos, sorted[pos]);
+                owner->endInsertItems();
+            }
+        }
+    }
+    owner->getPriv()->endBatch();
+}
+
+void ListSortModelPriv::modelItemsInserted(const ListIndex &index, int count)
+{
+    const auto group = proxyGroup(index.group);
+    auto& groupRows = rows[group];
+    for (auto& item : groupRows)
+    {
+        if (item >= index.item)
+        {
+            item += count;
+        }
+    }
+
+    // 新数据项逐个二分查找位置，多个插入合并为一次布局
+    owner->getPriv()->beginBatch();
+    for (int item = index.item; item < index.item + count; item++)
+    {
+        const auto pos = insertPosition(index.group, groupRows, item);
+        owner->beginInsertItems(ListIndex(group, pos), 1);
+        groupRows.insert(groupRows.begin() + pos, item);
+        owner->endInsertItems();
+    }
+    owner->getPriv()->endBatch();
+}
+
+void ListSortModelPriv::modelItemsRemoved(const ListIndex &index, int count)
+{
+    const auto group = proxyGroup(index.group);
+    auto& groupRows = rows[group];
+    const auto last = index.item + count;
+
+    // 先记下被删除的位置并换算其余的数据项，通知视图时保留的行都已指向删除后的源索引
+    std::vector<int> removed;
+    for (int pos = 0; pos < (int)groupRows.size(); pos++)
+    {
+        auto& item = groupRows[pos];
+        if (item >= last)
+        {
+            item -= count;
+        }
+        else if (item >= index.item)
+        {
+            removed.push_back(pos);
+        }
+    }
+
+    // 被删除的数据项分散在各处，从后往前逐个删除，保证前面的位置不变
+    owner->getPriv()->beginBatch();
+    for (auto it = removed.rbegin(); it != removed.rend(); it++)
+    {
+        owner->beginRemoveItems(ListIndex(group, *it), 1);
+        groupRows.erase(groupRows.begin() + *it);
+        owner->endRemoveItems();
+    }
+    owner->getPriv()->endBatch();
+}
+
+void ListSortModelPriv::modelGroupInserted(int group)
+{
+    for (auto& sourceGroup : groupOrder)
+    {
+        if (sourceGroup >= group)
+        {
+            sourceGroup++;
+        }
+    }
+
+    auto groupRows = sortedRows(group);
+    const auto pos = groupInsertPosition(group);
+    owner->beginInsertGroup(pos);
+    groupOrder.insert(groupOrder.begin() + pos, group);
+    rows.insert(rows.begin() + pos, std::move(groupRows));
+    owner->endInsertGroup();
+}
+
+void ListSortModelPriv::modelGroupRemoved(int group)
+{
+    const auto pos = proxyGroup(group);
+    owner->beginRemoveGroup(pos);
+    groupOrder.erase(groupOrder.begin() + pos);
+    rows.erase(rows.begin() + pos);
+    // endRemoveGroup 会立即重新布局，此前要换算为删除后的源分组
+    for (auto& sourceGroup : groupOrder)
+    {
+        if (sourceGroup > group)
+        {
+            sourceGroup--;
+        }
+    }
+    owner->endRemoveGroup();
+}
+
+void ListSortModelPriv::modelBatchBegin()
+{
+    owner->getPriv()->beginBatch();
+}
+
+void ListSortModelPriv::modelBatchEnd()
+{
+    owner->getPriv()->endBatch();
+}
+
+void ListSortModelPriv::modelDestroyed()
+{
+    source = nullptr;
+    reset();
+}
@@ -0,0 +1,61 @@
+#ifndef LISTSORTMODEL_H
+#define LISTSORTMODEL_H
+
+#include "listdatamodel.h"
+#include <functional>
+
+/**
+ * 排序代理模型
+ * 以另一个 ListDataModel 为源，对每个分组内的数据项排序，也可以对分组排序。
+ * 使用方法与 ListFilterModel 相同：setSourceModel 之后把此对象设置给 ListView ，
+ * delegate 中的索引是本模型的索引，可用 mapToSource 换算为源模型的索引。
+ *
+ * 设置源模型或排序规则时完整排序一次：分组内的数据项较多时分块在多个线程中并行排序再归并，
+ * 比较函数会被并发调用，只能读取可以并发读取的数据。
+ * 之后源模型插入的数据项按二分查找放到正确的位置；数据项更新后如果顺序改变，就作为一次移动
+ * （在同一批修改中删除再插入，只做一次布局）通知 ListView ，不会重新加载。
+ * 比较结果相等的数据项按源模型中的顺序排列。
+ */
+class ListSortModel : public ListDataModel
+{
+public:
+    /**
+     * 数据项比较函数，参数为同一分组中的两个源模型索引，a 应排在 b 之前时返回 true
+     */
+    typedef std::function<bool(const ListIndex& a, const ListIndex& b)> ItemLess;
+
+    /**
+     * 分组比较函数，参数为源模型的分组索引
+     */
+    typedef std::function<bool(int a, int b)> GroupLess;
+
+    ListSortModel();
+    ~ListSortModel();
+
+    void setSourceModel(ListDataModel* source);
+    ListDataModel* sourceModel() const;
+
+    /**
+     * 设置排序规则并重新排序
+     * @param itemLess 数据项比较函数，为空时保持源模型中的顺序
+     * @param groupLess 分组比较函数，为空时保持源模型中的顺序
+     */
+    void setSortOrder(ItemLess itemLess, GroupLess groupLess = GroupLess());
+
+    ListIndex mapToSource(const ListIndex& index) const;
+    ListIndex mapFromSource(const ListIndex& sourceIndex) const;
+
+    // ListDataModel interface
+public:
+    int numGroups() override;
+    int numItemsInGroup(int group) override;
+
+protected:
+    void* dataForIndex(const ListIndex& index) override;
+
+private:
+    friend class ListSortModelPriv;
+    class ListSortModelPriv* sortPriv;
+};
+
+#endif // LISTSORTMODEL_H
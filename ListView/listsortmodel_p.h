@@ -0,0 +1,63 @@
+#ifndef LISTSORTMODEL_P_H
+#define LISTSORTMODEL_P_H
+
+#include "listsortmodel.h"
+#include "listdatamodel_p.h"
+#include <vector>
+
+class ListSortModelPriv : public ListDataModelObserver
+{
+public:
+    ListSortModel* owner;
+    ListDataModel* source = nullptr;
+    ListSortModel::ItemLess itemLess;
+    ListSortModel::GroupLess groupLess;
+
+    // 本模型第 i 个分组对应的源分组
+    std::vector<int> groupOrder;
+    // 本模型每个分组中数据项对应的源数据项索引
+    std::vector<std::vector<int>> rows;
+
+    /**
+     * 重新排序所有分组与数据项
+     */
+    void reset();
+
+    /**
+     * 按源模型中的顺序生成分组 sourceGroup 的数据项并排序
+     */
+    std::vector<int> sortedRows(int sourceGroup) const;
+
+    /**
+     * 带有源索引作为次序的比较，保证任意两个不同的数据项都有确定的先后
+     */
+    bool itemBefore(int sourceGroup, int a, int b) const;
+    bool groupBefore(int a, int b) const;
+
+    /**
+     * 源分组在本模型中的位置
+     */
+    int proxyGroup(int sourceGroup) const;
+
+    /**
+     * 源数据项 item 在 groupRows 中应插入的位置，groupRows 中不能包含 item 本身
+     */
+    int insertPosition(int sourceGroup, const std::vector<int>& groupRows, int item) const;
+    int groupInsertPosition(int sourceGroup) const;
+
+    // ListDataModelObserver interface
+public:
+    void modelAboutToChange() override;
+    void modelReloaded() override;
+    void modelItemUpdated(const ListIndex& index) override;
+    void modelItemsUpdated(const ListIndex& first, int count) override;
+    void modelItemsInserted(const ListIndex& index, int count) override;
+    void modelItemsRemoved(const ListIndex& index, int count) override;
+    void modelGroupInserted(int group) override;
+    void modelGroupRemoved(int group) override;
+    void modelBatchBegin() override;
+    void modelBatchEnd() override;
+    void modelDestroyed() override;
+};
+
+#endif // LISTSORTMODEL_P_H
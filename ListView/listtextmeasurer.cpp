@@ -0,0 +1,261 @@
+#include "listtextmeasurer_p.h"
+#include <QRunnable>
+#include <QTextLayout>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// 每块至少排版的文本数目，文本较少时线程切换的开销大于收益
+const size_t ListTextMinChunk = 64;
+
+class ListTextTask : public QRunnable
+{
+public:
+    ListTextTask(const std::shared_ptr<ListTextShared>& shared, const std::shared_ptr<ListTextBatch>& batch, size_t first, size_t last)
+        : shared(shared), batch(batch), first(first), last(last)
+    {
+    }
+
+    void run() override
+    {
+        ListTextMeasurerPriv::run(shared, batch, first, last, true);
+    }
+
+private:
+    std::shared_ptr<ListTextShared> shared;
+    std::shared_ptr<ListTextBatch> batch;
+    size_t first;
+    size_t last;
+};
+
+}
+
+ListTextMeasurer::ListTextMeasurer(const QFont &font) : priv(new ListTextMeasurerPriv)
+{
+    priv->shared = std::make_shared<ListTextShared>();
+    setFont(font);
+}
+
+ListTextMeasurer::~ListTextMeasurer()
+{
+    // 排队中的块不再排版，等待正在执行的块结束
+    priv->shared->cancelled = true;
+    waitForPrefetch();
+    delete priv;
+}
+
+void ListTextMeasurer::setFont(const QFont &font)
+{
+    priv->font = font;
+    const auto key = font.key();
+    auto it = std::find(priv->fontKeys.begin(), priv->fontKeys.end(), key);
+    if (it == priv->fontKeys.end())
+    {
+        it = priv->fontKeys.insert(priv->fontKeys.end(), key);
+    }
+    priv->fontId = int(it - priv->fontKeys.begin());
+}
+
+QFont ListTextMeasurer::font() const
+{
+    return priv->font;
+}
+
+void ListTextMeasurer::setCacheLimit(size_t limit)
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    priv->shared->limit = limit;
+}
+
+void ListTextMeasurer::clearCache()
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    priv->shared->cache.clear();
+}
+
+size_t ListTextMeasurer::cacheSize() const
+{
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    return priv->shared->cache.size();
+}
+
+int ListTextMeasurer::height(const QString &text, int width)
+{
+    const auto key = priv->keyOf(text, width);
+    {
+        std::lock_guard<std::mutex> lock(priv->shared->mutex);
+        auto it = priv->shared->cache.find(key);
+        if (it != priv->shared->cache.end())
+        {
+            return it->second;
+        }
+    }
+    const auto result = ListTextMeasurerPriv::layoutHeight(text, priv->font, width);
+    std::lock_guard<std::mutex> lock(priv->shared->mutex);
+    priv->shared->insert(key, result);
+    return result;
+}
+
+std::vector<int> ListTextMeasurer::measureAll(const std::vector<QString> &texts, int width)
+{
+    std::vector<int> result(texts.size());
+    std::vector<size_t> positions;
+    auto batch = priv->collectMisses(texts, width, &result, &positions);
+    if (batch->texts.empty())
+    {
+        return result;
+    }
+
+    // 第一块在当前线程排版，其余块在线程池中排版
+    const auto firstEnd = priv->submit(batch, true);
+    ListTextMeasurerPriv::run(priv->shared, batch, 0, firstEnd, false);
+    {
+        std::unique_lock<std::mutex> lock(priv->shared->mutex);
+        priv->shared->finished.wait(lock, [&batch]{return batch->remaining == 0;});
+    }
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        result[positions[i]] = batch->heights[i];
+    }
+    return result;
+}
+
+void ListTextMeasurer::prefetch(const std::vector<QString> &texts, int width)
+{
+    auto batch = priv->collectMisses(texts, width, nullptr, nullptr);
+    if (!batch->texts.empty())
+    {
+        priv->submit(batch, false);
+    }
+}
+
+void ListTextMeasurer::waitForPrefetch()
+{
+    std::unique_lock<std::mutex> lock(priv->shared->mutex);
+    priv->shared->finished.wait(lock, [this]{return priv->shared->running == 0;});
+}
+
+
+
+void ListTextShared::insert(const ListTextKey &key, int height)
+{
+    if (limit > 0 && cache.size() >= limit)
+    {
+        cache.clear();
+    }
+    cache[key] = height;
+}
+
+ListTextKey ListTextMeasurerPriv::keyOf(const QString &text, int width) const
+{
+    return {fontId, width, qHash(text), text.size()};
+}
+
+int ListTextMeasurerPriv::layoutHeight(const QString &text, const QFont &font, int width)
+{
+    QTextOption option;
+    option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    QTextLayout layout(text, font);
+    layout.setTextOption(option);
+    layout.setCacheEnabled(false);
+
+    qreal height = 0;
+    layout.beginLayout();
+    for (auto line = layout.createLine(); line.isValid(); line = layout.createLine())
+    {
+        line.setLineWidth(std::max(width, 1));
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+    }
+    layout.endLayout();
+    return int(std::ceil(height));
+}
+
+std::shared_ptr<ListTextBatch> ListTextMeasurerPriv::collectMisses(const std::vector<QString> &texts, int width,
+                                                                 std::vector<int> *heights, std::vector<size_t> *positions)
+{
+    auto batch = std::make_shared<ListTextBatch>();
+    batch->font = font;
+    batch->fontId = fontId;
+    batch->width = width;
+
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    for (size_t i = 0; i < texts.size(); i++)
+    {
+        const auto key = keyOf(texts[i], width);
+        auto it = shared->cache.find(key);
+        if (it != shared->cache.end())
+        {
+            if (heights)
+            {
+                (*heights)[i] = it->second;
+            }
+            continue;
+        }
+        batch->texts.push_back(texts[i]);
+        batch->keys.push_back(key);
+        if (positions)
+        {
+            positions->push_back(i);
+        }
+    }
+    batch->heights.resize(batch->texts.size());
+    return batch;
+}
+
+size_t ListTextMeasurerPriv::submit(const std::shared_ptr<ListTextBatch> &batch, bool keepFirst)
+{
+    const auto size = batch->texts.size();
+    const auto threads = size_t(std::max(1, QThread::idealThreadCount()));
+    const auto parts = std::max<size_t>(1, std::min(threads, size / ListTextMinChunk));
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t i = 0; i <= parts; i++)
+    {
+        bounds[i] = size * i / parts;
+    }
+
+    const size_t firstPooled = keepFirst ? 1 : 0;
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        batch->remaining = int(parts);
+        shared->running += int(parts - firstPooled);
+    }
+    for (auto i = firstPooled; i < parts; i++)
+    {
+        QThreadPool::globalInstance()->start(new ListTextTask(shared, batch, bounds[i], bounds[i + 1]));
+    }
+    return keepFirst ? bounds[1] : 0;
+}
+
+void ListTextMeasurerPriv::run(const std::shared_ptr<ListTextShared> &shared, const std::shared_ptr<ListTextBatch> &batch,
+                               size_t first, size_t last, bool pooled)
+{
+    const auto cancelled = pooled && shared->cancelled.load();
+    if (!cancelled)
+    {
+        for (auto i = first; i < last; i++)
+        {
+            batch->heights[i] = layoutHeight(batch->texts[i], batch->font, batch->width);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (!cancelled)
+    {
+        for (auto i = first; i < last; i++)
+        {
+            shared->insert(batch->keys[i], batch->heights[i]);
+        }
+    }
+    batch->remaining--;
+    if (pooled)
+    {
+        shared->running--;
+    }
+    shared->finished.notify_all();
+}
@@ -0,0 +1,64 @@
+#ifndef LISTTEXTMEASURER_H
+#define LISTTEXTMEASURER_H
+
+#include <QFont>
+#include <QString>
+#include <vector>
+
+/**
+ * 文本高度测量服务
+ * 按给定宽度自动换行排版文本并返回高度，结果按 字体、宽度、文本哈希 缓存，相同的文本在相同的宽度下只排版一次。
+ * 批量测量 (measureAll / prefetch) 把未命中缓存的文本分块交给线程池并行排版。
+ *
+ * 与 ListViewDelegate 配合使用：
+ * 1. 在 prepareHeights 中取出即将测量的数据项的文本，调用 measureAll 并行排版
+ * 2. 在 heightForIndex 中调用 height ，此时直接命中缓存，再加上边距等固定部分
+ * 这样加载、宽度改变以及批量插入时的测量都在工作线程中完成，UI 线程只查表。
+ *
+ * 除 setFont 之外的接口可以在任意线程调用；setFont 不能与其他接口并发调用。
+ */
+class ListTextMeasurer
+{
+public:
+    explicit ListTextMeasurer(const QFont& font = QFont());
+    ~ListTextMeasurer();
+
+    /**
+     * 设置之后测量使用的字体，不同字体的结果分别缓存，切换字体不会清空缓存
+     */
+    void setFont(const QFont& font);
+    QFont font() const;
+
+    /**
+     * 缓存的最大条目数，超出时清空缓存，默认为 65536 ，0 表示不限制
+     */
+    void setCacheLimit(size_t limit);
+    void clearCache();
+    size_t cacheSize() const;
+
+    /**
+     * 返回文本在宽度 width 下自动换行后的高度，未命中缓存时在当前线程排版
+     */
+    int height(const QString& text, int width);
+
+    /**
+     * 并行测量一批文本，返回与 texts 一一对应的高度
+     * 未命中缓存的文本较多时分块交给线程池，当前线程也处理其中一块，返回前等待全部完成
+     */
+    std::vector<int> measureAll(const std::vector<QString>& texts, int width);
+
+    /**
+     * 在工作线程中预先测量，立即返回，结果写入缓存
+     */
+    void prefetch(const std::vector<QString>& texts, int width);
+
+    /**
+     * 等待所有 prefetch 完成
+     */
+    void waitForPrefetch();
+
+private:
+    class ListTextMeasurerPriv* priv;
+};
+
+#endif // LISTTEXTMEASURER_H
@@ -0,0 +1,103 @@
+#ifndef LISTTEXTMEASURER_P_H
+#define LISTTEXTMEASURER_P_H
+
+#include "listtextmeasurer.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * 缓存的键：字体编号、宽度，以及文本的哈希与长度
+ */
+struct ListTextKey
+{
+    int font;
+    int width;
+    uint hash;
+    int length;
+
+    bool operator==(const ListTextKey& other) const
+    {
+        return font == other.font && width == other.width && hash == other.hash && length == other.length;
+    }
+};
+
+struct ListTextKeyHash
+{
+    size_t operator()(const ListTextKey& key) const
+    {
+        return key.hash ^ (size_t(key.width) << 16) ^ (size_t(key.font) << 8) ^ size_t(key.length);
+    }
+};
+
+/**
+ * 一次批量测量，heights 与 texts 一一对应，remaining 为尚未完成的块数
+ */
+struct ListTextBatch
+{
+    QFont font;
+    int fontId = 0;
+    int width = 0;
+    std::vector<QString> texts;
+    std::vector<ListTextKey> keys;
+    std::vector<int> heights;
+    int remaining = 0;
+};
+
+/**
+ * 工作线程与测量服务共享的状态
+ * 测量服务删除时设置 cancelled 并等待 running 归零，排队中的块不再排版
+ */
+struct ListTextShared
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    int running = 0;
+    std::atomic<bool> cancelled{false};
+
+    size_t limit = 65536;
+    std::unordered_map<ListTextKey, int, ListTextKeyHash> cache;
+
+    /**
+     * 写入缓存，调用时需持有 mutex
+     */
+    void insert(const ListTextKey& key, int height);
+};
+
+class ListTextMeasurerPriv
+{
+public:
+    QFont font;
+    int fontId = 0;
+    // 用过的字体的 QFont::key ，下标即字体编号
+    std::vector<QString> fontKeys;
+    std::shared_ptr<ListTextShared> shared;
+
+    ListTextKey keyOf(const QString& text, int width) const;
+
+    /**
+     * 按宽度自动换行排版，返回所有行的总高度
+     */
+    static int layoutHeight(const QString& text, const QFont& font, int width);
+
+    /**
+     * 查询缓存，未命中的文本放入返回的批次中，positions 为它们在 texts 中的位置
+     */
+    std::shared_ptr<ListTextBatch> collectMisses(const std::vector<QString>& texts, int width,
+                                                 std::vector<int>* heights, std::vector<size_t>* positions);
+
+    /**
+     * 把批次分块，除 keepFirst 为 true 时的第一块外都提交到线程池，返回第一块的结束位置（keepFirst 为 false 时为 0）
+     */
+    size_t submit(const std::shared_ptr<ListTextBatch>& batch, bool keepFirst);
+
+    /**
+     * 排版批次中 [first, last) 的文本并写入缓存，pooled 表示在线程池中执行
+     */
+    static void run(const std::shared_ptr<ListTextShared>& shared, const std::shared_ptr<ListTextBatch>& batch,
+                    size_t first, size_t last, bool pooled);
+};
+
+#endif // LISTTEXTMEASURER_P_H
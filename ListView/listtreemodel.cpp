@@ -0,0 +1,382 @@
+#include "listtreemodel_p.h"
+#include <algorithm>
+
+ListTreeNode::~ListTreeNode()
+{
+    for (auto& pair : children)
+    {
+        delete pair.second;
+    }
+}
+
+
+
+ListTreeModel::ListTreeModel() : treePriv(new ListTreeModelPriv)
+{
+    treePriv->owner = this;
+    treePriv->root.expanded = true;
+}
+
+ListTreeModel::~ListTreeModel()
+{
+    delete treePriv;
+}
+
+void *ListTreeModel::dataForNode(const ListTreePath &)
+{
+    return nullptr;
+}
+
+void ListTreeModel::setExpanded(const ListTreePath &node, bool expanded)
+{
+    auto target = expanded ? treePriv->createNode(node) : treePriv->findNode(node);
+    if (!target || target == &treePriv->root || target->expanded == expanded)
+    {
+        return;
+    }
+
+    treePriv->load(target);
+    const auto count = target->rows.total();
+    if (count == 0 || !treePriv->isVisible(target))
+    {
+        target->expanded = expanded;
+        treePriv->propagate(target, expanded ? count : -count);
+        return;
+    }
+
+    // 子孙行在展平后的列表中是紧接在节点之后的一段连续行
+    const auto first = ListIndex(0, treePriv->rowOfChild(target, 0));
+    if (expanded)
+    {
+        beginInsertItems(first, count);
+        target->expanded = true;
+        treePriv->propagate(target, count);
+        endInsertItems();
+    }
+    else
+    {
+        beginRemoveItems(first, count);
+        target->expanded = false;
+        treePriv->propagate(target, -count);
+        endRemoveItems();
+    }
+}
+
+bool ListTreeModel::isExpanded(const ListTreePath &node) const
+{
+    auto target = treePriv->findNode(node);
+    return target && target->expanded;
+}
+
+ListTreePath ListTreeModel::pathForIndex(const ListIndex &index) const
+{
+    if (index.group != 0 || index.item < 0 || index.item >= treePriv->root.rows.total())
+    {
+        return ListTreePath();
+    }
+    int position;
+    auto parent = treePriv->locate(index.item, position);
+    auto result = treePriv->pathOf(parent);
+    result.push_back(position);
+    return result;
+}
+
+ListIndex ListTreeModel::indexForPath(const ListTreePath &node) const
+{
+    if (node.empty())
+    {
+        return ListIndex();
+    }
+
+    const ListTreeNode* parent = &treePriv->root;
+    int row = 0;
+    for (size_t level = 0; ; level++)
+    {
+        const auto position = node[level];
+        if (!parent->expanded || position < 0 || position >= parent->rows.size())
+        {
+            return ListIndex();
+        }
+        row += parent->rows.prefix(position) + (parent->parent ? 1 : 0);
+        if (level + 1 == node.size())
+        {
+            return ListIndex(0, row);
+        }
+        auto it = parent->children.find(position);
+        if (it == parent->children.end())
+        {
+            // 没有展开过的节点，其子节点都不可见
+            return ListIndex();
+        }
+        parent = it->second;
+    }
+}
+
+int ListTreeModel::numGroups()
+{
+    return 1;
+}
+
+int ListTreeModel::numItemsInGroup(int)
+{
+    treePriv->load(&treePriv->root);
+    return treePriv->root.rows.total();
+}
+
+int ListTreeModel::depthForIndex(const ListIndex &index)
+{
+    if (index.group != 0 || index.item < 0 || index.item >= treePriv->root.rows.total())
+    {
+        return 0;
+    }
+    int position;
+    return treePriv->locate(index.item, position)->depth + 1;
+}
+
+void *ListTreeModel::dataForIndex(const ListIndex &index)
+{
+    auto path = pathForIndex(index);
+    return path.empty() ? nullptr : dataForNode(path);
+}
+
+void ListTreeModel::beginInsertChildren(const ListTreePath &parent, int row, int count)
+{
+    auto& change = treePriv->change;
+    change.parent = treePriv->findNode(parent);
+    change.row = row;
+    change.count = count;
+    change.visibleRows = 0;
+    if (!change.parent || !change.parent->loaded)
+    {
+        // 没有展开过的节点在展开时才读取子节点数目
+        change.parent = nullptr;
+        return;
+    }
+    if (count > 0 && change.parent->expanded && treePriv->isVisible(change.parent))
+    {
+        change.visibleRows = count;
+        beginInsertItems(ListIndex(0, treePriv->rowOfChild(change.parent, row)), count);
+    }
+}
+
+void ListTreeModel::endInsertChildren()
+{
+    auto& change = treePriv->change;
+    auto parent = change.parent;
+    if (!parent)
+    {
+        return;
+    }
+    change.parent = nullptr;
+    treePriv->shiftChildren(parent, change.row, change.count);
+    parent->rows.insert(change.row, change.count, 1);
+    if (parent->expanded)
+    {
+        treePriv->propagate(parent, change.count);
+    }
+    if (change.visibleRows)
+    {
+        endInsertItems();
+    }
+}
+
+void ListTreeModel::beginRemoveChildren(const ListTreePath &parent, int row, int count)
+{
+    auto& change = treePriv->change;
+    change.parent = treePriv->findNode(parent);
+    change.row = row;
+    change.count = count;
+    change.visibleRows = 0;
+    if (!change.parent || !change.parent->loaded)
+    {
+        change.parent = nullptr;
+        return;
+    }
+    const auto& rows = change.parent->rows;
+    const auto removed = rows.prefix(row + count) - rows.prefix(row);
+    if (removed > 0 && change.parent->expanded && treePriv->isVisible(change.parent))
+    {
+        change.visibleRows = removed;
+        beginRemoveItems(ListIndex(0, treePriv->rowOfChild(change.parent, row)), removed);
+    }
+}
+
+void ListTreeModel::endRemoveChildren()
+{
+    auto& change = treePriv->change;
+    auto parent = change.parent;
+    if (!parent)
+    {
+        return;
+    }
+    change.parent = nullptr;
+    const auto removed = parent->rows.prefix(change.row + change.count) - parent->rows.prefix(change.row);
+    auto& children = parent->children;
+    auto first = children.lower_bound(change.row);
+    auto last = children.lower_bound(change.row + change.count);
+    for (auto it = first; it != last; it++)
+    {
+        delete it->second;
+    }
+    children.erase(first, last);
+    parent->rows.erase(change.row, change.count);
+    treePriv->shiftChildren(parent, change.row + change.count, -change.count);
+    if (parent->expanded)
+    {
+        treePriv->propagate(parent, -removed);
+    }
+    if (change.visibleRows)
+    {
+        endRemoveItems();
+    }
+}
+
+void ListTreeModel::nodeUpdated(const ListTreePath &node)
+{
+    const auto index = indexForPath(node);
+    if (!index.isEmpty())
+    {
+        itemUpdated(index);
+    }
+}
+
+void ListTreeModel::resetTree()
+{
+    auto& root = treePriv->root;
+    for (auto& pair : root.children)
+    {
+        delete pair.second;
+    }
+    root.children.clear();
+    root.rows.clear();
+    root.loaded = false;
+    treePriv->change.parent = nullptr;
+    requireReload();
+}
+
+
+
+ListTreePath ListTreeModelPriv::pathOf(const ListTreeNode *node) const
+{
+    ListTreePath result(node->depth + 1);
+    for (; node->parent; node = node->parent)
+    {
+        result[node->depth] = node->row;
+    }
+    return result;
+}
+
+ListTreeNode *ListTreeModelPriv::findNode(const ListTreePath &path) const
+{
+    auto node = const_cast<ListTreeNode*>(&root);
+    for (auto position : path)
+    {
+        auto it = node->children.find(position);
+        if (it == node->children.end())
+        {
+            return nullptr;
+        }
+        node = it->second;
+    }
+    return node;
+}
+
+ListTreeNode *ListTreeModelPriv::createNode(const ListTreePath &path)
+{
+    auto node = &root;
+    for (auto position : path)
+    {
+        load(node);
+        if (position < 0 || position >= node->rows.size())
+        {
+            return nullptr;
+        }
+        auto& child = node->children[position];
+        if (!child)
+        {
+            child = new ListTreeNode();
+            child->parent = node;
+            child->row = position;
+            child->depth = node->depth + 1;
+        }
+        node = child;
+    }
+    return node;
+}
+
+void ListTreeModelPriv::load(ListTreeNode *node)
+{
+    if (node->loaded)
+    {
+        return;
+    }
+    node->loaded = true;
+    node->rows.insert(0, std::max(0, owner->numChildren(pathOf(node))), 1);
+}
+
+void ListTreeModelPriv::propagate(ListTreeNode *node, int delta)
+{
+    while (node->parent && delta)
+    {
+        auto parent = node->parent;
+        parent->rows.set(node->row, parent->rows.height(node->row) + delta);
+        if (!parent->expanded)
+        {
+            break;
+        }
+        node = parent;
+    }
+}
+
+bool ListTreeModelPriv::isVisible(const ListTreeNode *node) const
+{
+    for (auto parent = node->parent; parent; parent = parent->parent)
+    {
+        if (!parent->expanded)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int ListTreeModelPriv::rowOfChild(const ListTreeNode *parent, int position) const
+{
+    // 每一层累加前面的兄弟节点占用的行数，非根节点还要加上父节点自身的一行
+    auto result = parent->rows.prefix(position);
+    for (auto node = parent; node->parent; node = node->parent)
+    {
+        result += node->parent->rows.prefix(node->row) + 1;
+    }
+    return result;
+}
+
+const ListTreeNode *ListTreeModelPriv::locate(int row, int &position) const
+{
+    auto node = &root;
+    while (true)
+    {
+        // 第一个底部 > row 的子节点，即 row 所在的子节点（或其子树）
+        position = node->rows.lowerBound(row + 1);
+        row -= node->rows.prefix(position);
+        if (row == 0)
+        {
+            return node;
+        }
+        // 子树中的行，只有展开的子节点才会占用多于一行
+        row -= 1;
+        node = node->children.find(position)->second;
+    }
+}
+
+void ListTreeModelPriv::shiftChildren(ListTreeNode *parent, int row, int delta)
+{
+    auto& children = parent->children;
+    std::map<int, ListTreeNode*> shifted;
+    for (auto it = children.lower_bound(row); it != children.end(); it = children.erase(it))
+    {
+        it->second->row += delta;
+        shifted.emplace(it->first + delta, it->second);
+    }
+    children.insert(shifted.begin(), shifted.end());
+}
@@ -0,0 +1,102 @@
+#ifndef LISTTREEMODEL_H
+#define LISTTREEMODEL_H
+
+#include "listdatamodel.h"
+#include <vector>
+
+/**
+ * 树中节点的路径，依次为从第一层开始每一层中的位置，空路径表示（不显示的）根节点
+ */
+typedef std::vector<int> ListTreePath;
+
+/**
+ * 树形数据模型
+ * 任意层级的树按展开状态展平为可见的行，全部放在分组 0 中（空树时也有这个分组），ListView 照常以 ListIndex(0, row) 展示，
+ * 复用、选中与 delegate 的接口都不变；delegate 用 pathForIndex 换算为节点路径，
+ * 数据项视图在 prepareItemView 时可以通过 ListViewItem::depth 取得节点的层级（第一层为 0）用于缩进。
+ *
+ * 节点的子节点只在它第一次展开时才向子类请求数目，没有展开过的子树不会创建任何节点。
+ * 每个展开过的节点用高度索引 (ListHeightIndex) 记录各子节点占用的可见行数，
+ * 行号与节点之间的换算、展开与折叠的簿记都是 O(depth * log n) ；展开或折叠时通知 ListView 插入或删除对应的连续行，
+ * 只测量新出现的行。折叠的节点保留子树的展开状态，再次展开时照原样恢复。
+ *
+ * 子类实现 numChildren ，修改树结构时使用本类的 begin/end*Children 与 nodeUpdated ，
+ * 不要直接调用 ListDataModel 中按分组与数据项修改的接口。
+ */
+class ListTreeModel : public ListDataModel
+{
+    /// 以下是子类需要实现的接口
+public:
+    /**
+     * 返回节点 parent 的子节点数目，parent 为空路径时返回第一层的节点数目
+     */
+    virtual int numChildren(const ListTreePath& parent) = 0;
+
+protected:
+    /**
+     * 子类可选择实现此函数，返回节点的数据对象指针，由 data() 调用
+     * 默认实现返回 nullptr
+     */
+    virtual void* dataForNode(const ListTreePath& node);
+
+public:
+    ListTreeModel();
+    ~ListTreeModel();
+
+    /**
+     * 展开或折叠节点，路径上尚未展开过的祖先节点会被创建但保持折叠
+     * 节点可见时通知 ListView 插入或删除其可见的子孙行
+     */
+    void setExpanded(const ListTreePath& node, bool expanded);
+    bool isExpanded(const ListTreePath& node) const;
+
+    /**
+     * 可见行对应的节点路径，分组头或无效的索引返回空路径
+     */
+    ListTreePath pathForIndex(const ListIndex& index) const;
+
+    /**
+     * 节点对应的可见行，节点不存在或有祖先节点折叠时返回空索引
+     */
+    ListIndex indexForPath(const ListTreePath& node) const;
+
+    // ListDataModel interface
+public:
+    int numGroups() override;
+    int numItemsInGroup(int group) override;
+    int depthForIndex(const ListIndex& index) override;
+
+protected:
+    void* dataForIndex(const ListIndex& index) override;
+
+    /// 以下是供子类调用的修改通知，与 ListDataModel 的 begin* / end* 一样必须在 UI 线程成对调用
+protected:
+    /**
+     * 在节点 parent 的第 row 个子节点处插入 count 个（折叠的）子节点
+     * parent 没有展开过时子类只需修改数据，本类在它展开时才读取子节点数目
+     */
+    void beginInsertChildren(const ListTreePath& parent, int row, int count);
+    void endInsertChildren();
+
+    /**
+     * 删除节点 parent 从第 row 个开始的 count 个子节点及其子树
+     */
+    void beginRemoveChildren(const ListTreePath& parent, int row, int count);
+    void endRemoveChildren();
+
+    /**
+     * 节点的数据有更新，节点可见时通知 ListView 重新测量
+     */
+    void nodeUpdated(const ListTreePath& node);
+
+    /**
+     * 树的结构有很大的改动，丢弃所有节点（包括展开状态）并重新加载
+     */
+    void resetTree();
+
+private:
+    friend class ListTreeModelPriv;
+    class ListTreeModelPriv* treePriv;
+};
+
+#endif // LISTTREEMODEL_H
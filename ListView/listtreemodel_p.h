@@ -0,0 +1,88 @@
+#ifndef LISTTREEMODEL_P_H
+#define LISTTREEMODEL_P_H
+
+#include "listtreemodel.h"
+#include "listheightindex_p.h"
+#include <map>
+
+/**
+ * 树中展开过（或作为展开过的节点的祖先）的节点
+ * 子节点占用的可见行数记录在 rows 中：折叠的子节点为 1 ，展开的子节点为 1 + 其可见的子孙行数。
+ * 只有在 children 中的子节点才有对应的 ListTreeNode ，其余子节点都是折叠且没有展开过的。
+ */
+struct ListTreeNode
+{
+    ListTreeNode* parent = nullptr;
+    // 在父节点中的位置
+    int row = 0;
+    // 第一层为 0 ，根节点为 -1
+    int depth = -1;
+    bool expanded = false;
+    // rows 是否已经按子节点数目建立
+    bool loaded = false;
+    ListHeightIndex rows;
+    std::map<int, ListTreeNode*> children;
+
+    ~ListTreeNode();
+};
+
+class ListTreeModelPriv
+{
+public:
+    ListTreeModel* owner;
+    ListTreeNode root;
+
+    // begin*Children 记录的修改，end*Children 时应用
+    struct
+    {
+        ListTreeNode* parent = nullptr;
+        int row = 0;
+        int count = 0;
+        // 通知给 ListView 的可见行数，为 0 时不通知
+        int visibleRows = 0;
+    }change;
+
+    ListTreePath pathOf(const ListTreeNode* node) const;
+
+    /**
+     * 按路径查找已创建的节点，不存在时返回 nullptr
+     */
+    ListTreeNode* findNode(const ListTreePath& path) const;
+
+    /**
+     * 按路径查找节点，路径上尚未创建的节点都以折叠状态创建
+     */
+    ListTreeNode* createNode(const ListTreePath& path);
+
+    /**
+     * 首次需要时向子类请求子节点数目，建立 rows
+     */
+    void load(ListTreeNode* node);
+
+    /**
+     * 节点（含自身）占用的可见行数改变了 delta ，向上更新祖先节点的 rows ，遇到折叠的祖先时停止
+     */
+    void propagate(ListTreeNode* node, int delta);
+
+    /**
+     * 所有祖先节点都展开时返回 true
+     */
+    bool isVisible(const ListTreeNode* node) const;
+
+    /**
+     * 父节点 parent 的第 position 个子节点所在的可见行，要求 parent 可见且展开
+     */
+    int rowOfChild(const ListTreeNode* parent, int position) const;
+
+    /**
+     * 可见行 row 对应的节点：返回其父节点，position 为在父节点中的位置
+     */
+    const ListTreeNode* locate(int row, int& position) const;
+
+    /**
+     * 把父节点中 >= row 的子节点位置移动 delta
+     */
+    void shiftChildren(ListTreeNode* parent, int row, int delta);
+};
+
+#endif // LISTTREEMODEL_P_H
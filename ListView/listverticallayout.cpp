@@ -0,0 +1,65 @@
+#include "listverticallayout_p.h"
+
+void ListVerticalLayout::clearGroups()
+{
+    groups.clear();
+}
+
+void ListVerticalLayout::insertGroupSlot(int group)
+{
+    groups.insert(groups.begin() + group, ListHeightIndex());
+}
+
+void ListVerticalLayout::removeGroupSlot(int group)
+{
+    groups.erase(groups.begin() + group);
+}
+
+int ListVerticalLayout::layoutGroup(int group, const ListHeights &itemHeights)
+{
+    auto& items = groups[group];
+    items.assign(itemHeights);
+    return items.total();
+}
+
+int ListVerticalLayout::layoutItemsInserted(int group, int first, int count, const ListHeights &itemHeights)
+{
+    auto& items = groups[group];
+    items.insert(first, itemHeights.begin() + first, itemHeights.begin() + first + count);
+    return items.total();
+}
+
+int ListVerticalLayout::layoutItemsRemoved(int group, int first, int count, const ListHeights &)
+{
+    auto& items = groups[group];
+    items.erase(first, count);
+    return items.total();
+}
+
+int ListVerticalLayout::layoutItemsUpdated(int group, int first, int count, const ListHeights &itemHeights)
+{
+    auto& items = groups[group];
+    for (auto item = first; item < first + count; item++)
+    {
+        items.set(item, itemHeights[item]);
+    }
+    return items.total();
+}
+
+QRect ListVerticalLayout::groupItemRect(int group, int item) const
+{
+    const auto& items = groups[group];
+    return QRect(0, items.prefix(item), width(), items.height(item));
+}
+
+void ListVerticalLayout::groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex> &result) const
+{
+    const auto& items = groups[group];
+    auto item = items.lowerBound(top);
+    auto y = items.prefix(item);
+    for (; item < items.size() && y <= bottom; item++)
+    {
+        result.push_back(ListIndex(group, item));
+        y += items.height(item);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef LISTVERTICALLAYOUT_P_H
+#define LISTVERTICALLAYOUT_P_H
+
+#include "listlayoutengine_p.h"
+
+/**
+ * 纵向列表布局，每个数据项占满整行
+ * 每个分组用一个高度索引保存数据项高度，更新单个数据项与按位置查找均为 O(log n) 。
+ */
+class ListVerticalLayout : public ListLayoutEngine
+{
+protected:
+    void clearGroups() override;
+    void insertGroupSlot(int group) override;
+    void removeGroupSlot(int group) override;
+    int layoutGroup(int group, const ListHeights& itemHeights) override;
+    int layoutItemsInserted(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsRemoved(int group, int first, int count, const ListHeights& itemHeights) override;
+    int layoutItemsUpdated(int group, int first, int count, const ListHeights& itemHeights) override;
+    QRect groupItemRect(int group, int item) const override;
+    void groupItemsInRange(int group, int top, int bottom, std::vector<ListIndex>& result) const override;
+
+private:
+    std::deque<ListHeightIndex> groups;
+};
+
+#endif // LISTVERTICALLAYOUT_P_H
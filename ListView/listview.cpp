@@ -1,7 +1,12 @@
 #include "listview_p.h"
 #include "listviewitem_p.h"
 #include "listdatamodel_p.h"
-#include "listview_p.h"
+#include "listverticallayout_p.h"
+#include "listgridlayout_p.h"
+#include "listmasonrylayout_p.h"
+#include "listlayoutsnapshot_p.h"
+#include <QElapsedTimer>
+#include <QMetaMethod>
 #include <QMouseEvent>
 #include <QResizeEvent>
 #include <QScrollBar>
@@ -33,6 +38,15 @@ QString ListViewScrollBarStyle = QStringLiteral(
             }
             )");
 
+// 暂停期间最多记录的修改条数，超过时放弃记录，恢复时重新加载
+static const int ListViewJournalLimit = 1024;
+
+// visibleRangeChanged 信号的最小间隔，即一帧
+static const int ListViewRangeInterval = 16;
+
+// 空闲时每一轮清理回收视图的时间预算，超出后留到下一轮
+static const qint64 ListViewCleanBudgetNs = 2000000;
+
 class OrderedListHelper
 {
 public:
@@ -88,6 +102,26 @@ void ListView::setViewDelegate(ListViewDelegate *delegate)
     priv->setViewDelegate(delegate);
 }
 
+void ListView::setLayoutMode(ListView::LayoutMode mode)
+{
+    priv->setLayoutMode(mode);
+}
+
+ListView::LayoutMode ListView::layoutMode() const
+{
+    return priv->getLayoutMode();
+}
+
+void ListView::setAnchorMode(ListView::AnchorMode mode)
+{
+    priv->setAnchorMode(mode);
+}
+
+ListView::AnchorMode ListView::anchorMode() const
+{
+    return priv->getAnchorMode();
+}
+
 ListDataModel *ListView::dataModel() const
 {
     return priv->dataModel();
@@ -106,7 +140,7 @@ std::list<ListIndex> ListView::selection()
 void ListView::setSelection(std::list<ListIndex> &&selection)
 {
     auto tmp = std::move(selection);
-    priv->setSelection(selection);
+    priv->setSelection(tmp);
 }
 
 void ListView::setSelection(const std::list<ListIndex> &selection)
@@ -129,6 +163,86 @@ void ListView::scrollToBottom()
     priv->scrollToBottom();
 }
 
+ListViewRange ListView::visibleRange() const
+{
+    return priv->visibleRange();
+}
+
+ListIndex ListView::indexAt(const QPoint &pos) const
+{
+    return priv->indexAt(pos);
+}
+
+QRect ListView::itemRect(const ListIndex &index) const
+{
+    return priv->itemRect(index);
+}
+
+void ListView::setGroupCollapsed(int group, bool collapsed)
+{
+    priv->setGroupCollapsed(group, collapsed);
+}
+
+bool ListView::isGroupCollapsed(int group) const
+{
+    return priv->isGroupCollapsed(group);
+}
+
+size_t ListView::reusePoolMemory() const
+{
+    return priv->reusePoolMemory();
+}
+
+void ListView::releasePooledViews()
+{
+    priv->cleanPooledViews(-1);
+}
+
+ListViewStats ListView::stats() const
+{
+    return priv->getStats();
+}
+
+void ListView::resetStats()
+{
+    priv->resetStats();
+}
+
+void ListView::setFrameBudget(int us)
+{
+    priv->setFrameBudget(us);
+}
+
+void ListView::setStatsInterval(int ms)
+{
+    priv->setStatsInterval(ms);
+}
+
+void ListView::setSuspended(bool suspended)
+{
+    priv->setSuspended(suspended);
+}
+
+bool ListView::isSuspended() const
+{
+    return priv->isSuspended();
+}
+
+void ListView::setModelCacheSize(int count)
+{
+    priv->setModelCacheSize(count);
+}
+
+QByteArray ListView::saveLayoutSnapshot()
+{
+    return priv->saveSnapshot();
+}
+
+void ListView::restoreLayoutSnapshot(const QByteArray &snapshot)
+{
+    priv->restoreSnapshot(snapshot);
+}
+
 ListViewPriv *ListView::getPriv() const
 {
     return priv;
@@ -139,6 +253,24 @@ void ListView::resizeEvent(QResizeEvent *event)
     priv->onResized(event->oldSize());
 }
 
+void ListView::showEvent(QShowEvent *)
+{
+    priv->setHidden(false);
+}
+
+void ListView::hideEvent(QHideEvent *)
+{
+    priv->setHidden(true);
+}
+
+void ListView::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&ListView::visibleRangeChanged))
+    {
+        priv->watchVisibleRange();
+    }
+}
+
 
 
 void ListViewPriv::setup()
@@ -161,16 +293,22 @@ void ListViewPriv::setup()
     scrollContent->setAutoFillBackground(false);
     scrollArea->viewport()->setAutoFillBackground(false);
 
+    layout = createLayout(layoutMode);
+
     QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
 }
 
 void ListViewPriv::cleanup()
 {
+    clearModelCache();
     if (currentModel)
     {
+        detachHeights();
         currentModel->listViewPrivs.erase(this);
         currentModel = nullptr;
     }
+    delete layout;
+    layout = nullptr;
 }
 
 void ListViewPriv::processItemClick(QMouseEvent *event, const ListIndex &index, ListViewItemPriv *item)
@@ -198,6 +336,7 @@ void ListViewPriv::setDataModel(ListDataModel *model)
         return;
     }
 
+    stashModelState();
     clear();
 
     if (currentModel)
@@ -209,21 +348,74 @@ void ListViewPriv::setDataModel(ListDataModel *model)
 
     if (currentModel)
     {
+        // 先让已关联的视图同步累积的追加，本视图随后完整加载
+        model->flushAppends();
         currentModel->listViewPrivs.insert(this);
     }
 
-    reload();
+    if (!restoreModelState())
+    {
+        reload();
+    }
 }
 
 void ListViewPriv::setViewDelegate(ListViewDelegate *delegate)
 {
+    // 保存的高度与分组头都来自原来的 delegate ，回收的视图也要由原来的 delegate 清理
+    clearModelCache();
     clear();
+    cleanPooledViews(-1);
 
     currentDelegate = delegate;
+    layout->setDelegate(delegate);
 
     reload();
 }
 
+void ListViewPriv::setLayoutMode(ListView::LayoutMode mode)
+{
+    if (layoutMode == mode)
+    {
+        return;
+    }
+
+    // 切换布局方式时保留选中与折叠状态
+    auto selection = selected;
+    auto collapsed = collapsedGroups;
+    clearModelCache();
+    clear();
+    delete layout;
+    layoutMode = mode;
+    layout = createLayout(mode);
+    selected = selection;
+    collapsedGroups = collapsed;
+    reload();
+}
+
+ListView::LayoutMode ListViewPriv::getLayoutMode() const
+{
+    return layoutMode;
+}
+
+void ListViewPriv::setAnchorMode(ListView::AnchorMode mode)
+{
+    if (anchorMode == mode)
+    {
+        return;
+    }
+
+    anchorMode = mode;
+    if (mode == ListView::AnchorBottom)
+    {
+        scrollToBottom();
+    }
+}
+
+ListView::AnchorMode ListViewPriv::getAnchorMode() const
+{
+    return anchorMode;
+}
+
 ListDataModel *ListViewPriv::dataModel() const
 {
     return currentModel->owner;
@@ -267,32 +459,19 @@ void ListViewPriv::setSelection(const std::list<ListIndex> &selection)
 
 void ListViewPriv::scrollToItem(const ListIndex &index)
 {
+    applyJournal();
     if (!currentModel || currentModel->owner->isEmpty())
     {
         return;
     }
 
-    if (index.group < 0 || index.group >= (int)itemHeights.size()
-            || index.item < -1 || index.item >= (int)itemHeights[index.group].size())
+    if (!isValidIndex(index))
     {
         // invalid index
         return;
     }
 
-    int targetY;
-    if (loadedItems.empty())
-    {
-        targetY = itemPosition(index, ListIndex(), 0);
-    }
-    else
-    {
-        const auto& item = loadedItems.front();
-        const auto refIndex = item.index;
-        int refY = item.y;
-        targetY = itemPosition(index, refIndex, refY);
-    }
-
-    scrollArea->verticalScrollBar()->setValue(targetY);
+    scrollArea->verticalScrollBar()->setValue(layout->itemRect(index).y());
 }
 
 void ListViewPriv::scrollToTop()
@@ -308,69 +487,87 @@ void ListViewPriv::scrollToBottom()
 
 void ListViewPriv::requireReload()
 {
+    if (isSuspended() && currentModel && currentDelegate)
+    {
+        // 恢复时重新加载，此前的修改记录不再需要
+        journal.clear();
+        reloadOnResume = true;
+        selected.clear();
+        return;
+    }
+
     clear();
     reload();
+    if (batchDepth > 0)
+    {
+        batchAnchor = captureAnchor();
+        batchChanged = true;
+    }
 }
 
-void ListViewPriv::itemUpdated(const ListIndex &index)
+void ListViewPriv::itemsUpdated(const ListIndex &first, int count)
 {
-    if (!currentDelegate)
+    // 分组头的高度由其视图决定，更新分组头不影响布局
+    if (!currentDelegate || first.isHeader())
     {
         return;
     }
-    auto itemNewHeight = currentDelegate->heightForIndex(index, owner->width());
-    auto itemOldHeight = itemHeights[index.group][index.item];
-    auto dh = itemNewHeight - itemOldHeight;
-    contentHeight += dh;
-    itemHeights[index.group][index.item] = itemNewHeight;
-    if (!loadedItems.empty())
-    {
-        auto it = std::lower_bound(loadedItems.begin(), loadedItems.end(), index, [](const LoadedItem& item, const ListIndex& idx)
-        {
-            return item.index < idx;
-        });
-
-        // adjust loadedItems's size and position
-        if (it != loadedItems.end() && it->index == index)
-        {
-            it->view->owner->resize(owner->width(), itemNewHeight);
-            it->h = itemNewHeight;
-
-            while (++it != loadedItems.end())
-            {
-                auto& item = *it;
-                item.y += dh;
-                QWidget* view = (item.index.item == ListIndex::InvalidItemIndex)
-                        ? headerViews[item.index.group]
-                        : item.view->owner;
-                if (view)
-                {
-                    view->move(0, item.y);
-                }
-            }
-        }
 
-        // 调整前断掉信号连接~
-        auto vs = scrollArea->verticalScrollBar();
-        vs->disconnect(owner);
+    modifyInfo.mode = ModifyModeUpdateItem;
+    modifyInfo.index = first;
+    modifyInfo.count = count;
+    const auto deferred = journalChange();
+    modifyInfo.mode = ModifyModeNone;
+    if (deferred)
+    {
+        return;
+    }
 
-        // 调整scrollContent 高度
-        fixContentSize(false);
+    // 以已加载项为锚点，变动的 item 在视口上方时视觉保持不变
+    auto anchor = captureAnchor();
+    if (anchorMode == ListView::AnchorTop)
+    {
+        // 如果变动的 item 包括最后一个，就直接滚动到最底部
+        anchor.bottom = !loadedItems.empty() && currentModel->owner->maxIndex() == ListIndex(first.group, first.item + count - 1);
+    }
 
-        // 如果变动的 item 是最后一个，就直接滚动到最底部
-        if (currentModel->owner->maxIndex() == index)
+    auto& groupItemHeights = heights->itemHeights[first.group];
+    if (claimHeights())
+    {
+        const auto width = layout->itemWidth(first.group);
+        prepareHeights(first.group, first.item, count, width);
+        heights->updateChanged = false;
+        for (int item = first.item; item < first.item + count; item++)
         {
-            vs->setValue(vs->maximum());
+            const auto height = measureHeight(ListIndex(first.group, item), width);
+            heights->updateChanged |= height != groupItemHeights[item];
+            groupItemHeights[item] = height;
         }
-        // 如果变动的 item 在 loadedItems 前面，那么可以滚动视图保持视觉不变
-        else if (index < loadedItems.begin()->index)
+    }
+
+    // 高度都没有变化时不需要布局，只重绘已加载的视图
+    if (!heights->updateChanged)
+    {
+        const ListIndex last(first.group, first.item + count - 1);
+        for (auto& item : loadedItems)
         {
-            vs->setValue(vs->value() + dh);
+            if (item.view && item.index >= first && item.index <= last)
+            {
+                item.view->owner->update();
+            }
         }
+        return;
+    }
 
-        QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
+    layout->itemsUpdated(first.group, first.item, count, groupItemHeights);
+    if (batchDepth == 0)
+    {
+        relayout(anchor);
+    }
+    else
+    {
+        batchChanged = true;
     }
-    adjustLoadedItems();
 }
 
 void ListViewPriv::beginInsertItem(const ListIndex &insertIndex, size_t count)
@@ -383,6 +580,11 @@ void ListViewPriv::beginInsertItem(const ListIndex &insertIndex, size_t count)
     modifyInfo.mode = ModifyModeInsertItem;
     modifyInfo.index = insertIndex;
     modifyInfo.count = count;
+    modifyInfo.deferred = journalChange();
+    if (!modifyInfo.deferred)
+    {
+        modifyInfo.anchor = captureAnchor();
+    }
 }
 
 void ListViewPriv::endInsertItem()
@@ -392,39 +594,31 @@ void ListViewPriv::endInsertItem()
         return;
     }
     Q_ASSERT(modifyInfo.mode == ModifyModeInsertItem);
-    const auto width = owner->width();
-    auto& groupItemHeights = itemHeights[modifyInfo.index.group];
-    groupItemHeights.insert(groupItemHeights.begin() + modifyInfo.index.item, modifyInfo.count, 0);
-    int insertedTotalHeight = 0;
-    for (int item = modifyInfo.index.item; item < modifyInfo.index.item + modifyInfo.count; item++)
+    if (modifyInfo.deferred)
     {
-        auto& itemHeight = groupItemHeights.at(item);
-        itemHeight = currentDelegate->heightForIndex(ListIndex(modifyInfo.index.group, item), width);
-        insertedTotalHeight += itemHeight;
+        // 暂停期间只记录修改，选中列表仍随修改即时更新
+        shiftSelection();
+        modifyInfo.mode = ModifyModeNone;
+        emit owner->itemsInserted(modifyInfo.index, modifyInfo.count);
+        return;
     }
-    contentHeight += insertedTotalHeight;
-
-    while (!loadedItems.empty() && loadedItems.back().index >= modifyInfo.index)
+    const auto width = layout->itemWidth(modifyInfo.index.group);
+    auto& groupItemHeights = heights->itemHeights[modifyInfo.index.group];
+    if (claimHeights())
     {
-        auto& item = loadedItems.back();
-        ListIndex newIndex = (item.index.group == modifyInfo.index.group)
-                ? ListIndex(item.index.group, item.index.item + modifyInfo.count)
-                : item.index;
-        adjustItem(item, newIndex, item.y + insertedTotalHeight);
-        pendingItems[newIndex] = item;
-        loadedItems.pop_back();
+        groupItemHeights.insert(groupItemHeights.begin() + modifyInfo.index.item, modifyInfo.count, 0);
+        prepareHeights(modifyInfo.index.group, modifyInfo.index.item, modifyInfo.count, width);
+        for (int item = modifyInfo.index.item; item < modifyInfo.index.item + modifyInfo.count; item++)
+        {
+            groupItemHeights[item] = measureHeight(ListIndex(modifyInfo.index.group, item), width);
+        }
     }
+    layout->itemsInserted(modifyInfo.index.group, modifyInfo.index.item, modifyInfo.count, groupItemHeights);
 
-    // 重建选中列表，调整其中大于等于 modifyInfo.index 的索引号。
-    auto selectedIt = std::lower_bound(selected.begin(), selected.end(), modifyInfo.index);
-    while (selectedIt != selected.end() && selectedIt->group == modifyInfo.index.group)
-    {
-        selectedIt->item += modifyInfo.count;
-        selectedIt++;
-    }
+    shiftLoadedItems();
+    shiftSelection();
 
-    fixContentSize(false);
-    adjustLoadedItems();
+    finishModify();
     modifyInfo.mode = ModifyModeNone;
     emit owner->itemsInserted(modifyInfo.index, modifyInfo.count);
 }
@@ -439,6 +633,11 @@ void ListViewPriv::beginInsertGroup(int groupIndex)
     modifyInfo.mode = ModifyModeInsertGroup;
     modifyInfo.index = ListIndex(groupIndex);
     modifyInfo.count = 1;
+    modifyInfo.deferred = journalChange();
+    if (!modifyInfo.deferred)
+    {
+        modifyInfo.anchor = captureAnchor();
+    }
 }
 
 void ListViewPriv::endInsertGroup()
@@ -448,47 +647,43 @@ void ListViewPriv::endInsertGroup()
         return;
     }
     Q_ASSERT(modifyInfo.mode == ModifyModeInsertGroup);
-    const auto width = owner->width();
-
-    auto headerView = currentDelegate->headerViewForGroup(modifyInfo.index.group);
-    if (headerView)
+    if (modifyInfo.deferred)
     {
-        headerView->setParent(scrollContent);
+        // 暂停期间只记录修改，选中列表仍随修改即时更新
+        shiftSelection();
+        modifyInfo.mode = ModifyModeNone;
+        emit owner->groupInserted(modifyInfo.index.group);
+        return;
     }
-    headerViews.insert(headerViews.begin() + modifyInfo.index.group, headerView);
+    const auto group = modifyInfo.index.group;
 
-    auto& groupItemHeights = *(itemHeights.insert(itemHeights.begin() + modifyInfo.index.group, modifyInfo.count, {}));
-    auto numItems = currentModel->owner->numItemsInGroup(modifyInfo.index.group);
-    groupItemHeights.resize(numItems);
-    int insertedTotalHeight = 0;
-    for (int item = 0; item < numItems; item++)
+    auto headerView = currentDelegate->headerViewForGroup(group);
+    if (headerView)
     {
-        auto& itemHeight = groupItemHeights[item];
-        itemHeight = currentDelegate->heightForIndex(ListIndex(modifyInfo.index.group, item), width);
-        insertedTotalHeight += itemHeight;
+        headerView->setParent(scrollContent);
     }
-    insertedTotalHeight += (headerView ? headerView->height() : 0);
-    contentHeight += insertedTotalHeight;
+    headerViews.insert(headerViews.begin() + group, headerView);
+    collapsedGroups.insert(collapsedGroups.begin() + group, false);
 
-    while (!loadedItems.empty() && loadedItems.back().index >= modifyInfo.index)
+    if (claimHeights())
     {
-        auto& item = loadedItems.back();
-        ListIndex newIndex = ListIndex(item.index.group + 1, item.index.item);
-        adjustItem(item, newIndex, item.y + insertedTotalHeight);
-        pendingItems[newIndex] = item;
-        loadedItems.pop_back();
+        auto& groupItemHeights = *(heights->itemHeights.insert(heights->itemHeights.begin() + group, ListHeights()));
+        auto numItems = currentModel->owner->numItemsInGroup(group);
+        groupItemHeights.resize(numItems);
+        const auto width = layout->itemWidth(group);
+        prepareHeights(group, 0, numItems, width);
+        for (int item = 0; item < numItems; item++)
+        {
+            groupItemHeights[item] = measureHeight(ListIndex(group, item), width);
+        }
     }
+    const auto& groupItemHeights = heights->itemHeights[group];
+    layout->insertGroup(group, headerHeight(group), groupItemHeights, false);
 
-    // 重建选中列表，调整其中大于等于 modifyInfo.index 的索引号。
-    auto selectedIt = std::lower_bound(selected.begin(), selected.end(), modifyInfo.index);
-    while (selectedIt != selected.end())
-    {
-        selectedIt->group += 1;
-        selectedIt++;
-    }
+    shiftLoadedItems();
+    shiftSelection();
 
-    fixContentSize(false);
-    adjustLoadedItems();
+    finishModify();
     modifyInfo.mode = ModifyModeNone;
     emit owner->groupInserted(modifyInfo.index.group);
 }
@@ -503,6 +698,11 @@ void ListViewPriv::beginRemoveItem(const ListIndex &removeIndex, size_t count)
     modifyInfo.mode = ModifyModeRemoveItem;
     modifyInfo.index = removeIndex;
     modifyInfo.count = count;
+    modifyInfo.deferred = journalChange();
+    if (!modifyInfo.deferred)
+    {
+        modifyInfo.anchor = captureAnchor();
+    }
 }
 
 void ListViewPriv::endRemoveItem()
@@ -512,53 +712,25 @@ void ListViewPriv::endRemoveItem()
         return;
     }
     Q_ASSERT(modifyInfo.mode == ModifyModeRemoveItem);
-    auto& groupItemHeights = itemHeights[modifyInfo.index.group];
-    int deletedTotalHeight = 0;
-    for (int item = modifyInfo.index.item; item < modifyInfo.index.item + modifyInfo.count; item++)
-    {
-        const auto& itemHeight = groupItemHeights.at(item);
-        deletedTotalHeight += itemHeight;
-    }
-    contentHeight -= deletedTotalHeight;
-    groupItemHeights.erase(groupItemHeights.begin() + modifyInfo.index.item, groupItemHeights.begin() + modifyInfo.index.item + modifyInfo.count);
-
-    while (!loadedItems.empty() && loadedItems.back().index >= modifyInfo.index)
+    if (modifyInfo.deferred)
     {
-        auto& item = loadedItems.back();
-        if (item.index.group == modifyInfo.index.group && item.index.item < modifyInfo.index.item + modifyInfo.count)
-        {
-            // This item has been removed, now recycle the view.
-            item.view->owner->hide();
-            reusePool[item.view->owner->metaObject()].push_back(item.view);
-        }
-        else
-        {
-            ListIndex newIndex = (item.index.group == modifyInfo.index.group)
-                    ? ListIndex(item.index.group, item.index.item - modifyInfo.count)
-                    : item.index;
-            adjustItem(item, newIndex, item.y - deletedTotalHeight);
-            pendingItems[newIndex] = item;
-        }
-        loadedItems.pop_back();
+        // 暂停期间只记录修改，选中列表仍随修改即时更新
+        shiftSelection();
+        modifyInfo.mode = ModifyModeNone;
+        emit owner->itemsRemoved(modifyInfo.index, modifyInfo.count);
+        return;
     }
+    shiftLoadedItems();
 
-    // 重建选中列表，删除对应的索引，并调整其中大于等于 modifyInfo.index 的索引号。
-    auto selectedIt = std::lower_bound(selected.begin(), selected.end(), modifyInfo.index);
-    while (selectedIt != selected.end() && selectedIt->group == modifyInfo.index.group)
+    auto& groupItemHeights = heights->itemHeights[modifyInfo.index.group];
+    if (claimHeights())
     {
-        if (selectedIt->item < modifyInfo.index.item + modifyInfo.count)
-        {
-            selectedIt = selected.erase(selectedIt);
-        }
-        else
-        {
-            selectedIt->group -= modifyInfo.count;
-            selectedIt++;
-        }
+        groupItemHeights.erase(groupItemHeights.begin() + modifyInfo.index.item, groupItemHeights.begin() + modifyInfo.index.item + modifyInfo.count);
     }
+    layout->itemsRemoved(modifyInfo.index.group, modifyInfo.index.item, modifyInfo.count, groupItemHeights);
+    shiftSelection();
 
-    fixContentSize(false);
-    adjustLoadedItems();
+    finishModify();
     modifyInfo.mode = ModifyModeNone;
     emit owner->itemsRemoved(modifyInfo.index, modifyInfo.count);
 }
@@ -573,6 +745,11 @@ void ListViewPriv::beginRemoveGroup(int groupIndex)
     modifyInfo.mode = ModifyModeRemoveGroup;
     modifyInfo.index = ListIndex(groupIndex);
     modifyInfo.count = 1;
+    modifyInfo.deferred = journalChange();
+    if (!modifyInfo.deferred)
+    {
+        modifyInfo.anchor = captureAnchor();
+    }
 }
 
 void ListViewPriv::endRemoveGroup()
@@ -582,61 +759,31 @@ void ListViewPriv::endRemoveGroup()
         return;
     }
     Q_ASSERT(modifyInfo.mode == ModifyModeRemoveGroup);
-    auto& groupItemHeights = itemHeights[modifyInfo.index.group];
-    int deletedTotalHeight = 0;
-    for (auto& height : groupItemHeights)
+    if (modifyInfo.deferred)
     {
-        deletedTotalHeight += height;
-    }
-    if (auto& view = headerViews[modifyInfo.index.group])
-    {
-        deletedTotalHeight += view->height();
-        view->height();
-        delete view;
+        // 暂停期间只记录修改，选中列表仍随修改即时更新
+        shiftSelection();
+        modifyInfo.mode = ModifyModeNone;
+        emit owner->groupRemoved(modifyInfo.index.group);
+        return;
     }
-    contentHeight -= deletedTotalHeight;
-    itemHeights.erase(itemHeights.begin() + modifyInfo.index.group);
-    headerViews.erase(headerViews.begin() + modifyInfo.index.group);
+    shiftLoadedItems();
 
-    while (!loadedItems.empty() && loadedItems.back().index >= modifyInfo.index)
+    const auto group = modifyInfo.index.group;
+    if (auto& view = headerViews[group])
     {
-        auto& item = loadedItems.back();
-        if (item.index.group == modifyInfo.index.group)
-        {
-            // This item has been removed, recycle the view.
-            // Ignore the header view
-            if (item.index.item != ListIndex::InvalidItemIndex)
-            {
-                item.view->owner->hide();
-                reusePool[item.view->owner->metaObject()].push_back(item.view);
-            }
-        }
-        else
-        {
-            ListIndex newIndex = ListIndex(item.index.group - 1, item.index.item);
-            adjustItem(item, newIndex, item.y - deletedTotalHeight);
-            pendingItems[newIndex] = item;
-        }
-        loadedItems.pop_back();
+        delete view;
     }
-
-    // 重建选中列表，删除对应的索引，调整其中大于等于 modifyInfo.index 的索引号。
-    auto selectedIt = std::lower_bound(selected.begin(), selected.end(), modifyInfo.index);
-    while (selectedIt != selected.end())
+    if (claimHeights())
     {
-        if (selectedIt->group == modifyInfo.index.group)
-        {
-            selectedIt = selected.erase(selectedIt);
-        }
-        else
-        {
-            selectedIt->group -= 1;
-            selectedIt++;
-        }
+        heights->itemHeights.erase(heights->itemHeights.begin() + group);
     }
+    headerViews.erase(headerViews.begin() + group);
+    collapsedGroups.erase(collapsedGroups.begin() + group);
+    layout->removeGroup(group);
+    shiftSelection();
 
-    fixContentSize(false);
-    adjustLoadedItems();
+    finishModify();
     modifyInfo.mode = ModifyModeNone;
     emit owner->groupRemoved(modifyInfo.index.group);
 }
@@ -644,6 +791,26 @@ void ListViewPriv::endRemoveGroup()
 void ListViewPriv::onResized(const QSize& oldSize)
 {
     scrollArea->verticalScrollBar()->disconnect(owner);
+    const auto widthChanged = oldSize.width() != owner->width();
+    if (hasPendingChanges())
+    {
+        // 暂停期间布局已过期，留到恢复时处理；宽度改变后无法重放修改记录，恢复时重新加载
+        if (widthChanged)
+        {
+            journal.clear();
+            reloadOnResume = true;
+        }
+        scrollArea->setGeometry(owner->rect());
+        if (emptyView)
+        {
+            emptyView->setGeometry(owner->rect());
+        }
+        QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
+        return;
+    }
+    // 宽度不变时布局不变，底部锚定模式下仍需在视口高度改变后保持底部的内容不动
+    const auto keepBottom = !widthChanged && anchorMode == ListView::AnchorBottom;
+    const auto anchor = keepBottom ? captureAnchor() : ScrollAnchor();
     scrollArea->setGeometry(owner->rect());
 
     if (emptyView)
@@ -651,43 +818,149 @@ void ListViewPriv::onResized(const QSize& oldSize)
         emptyView->setGeometry(owner->rect());
     }
 
-    fixContentSize(oldSize.width() != owner->width());
+    fixContentSize(widthChanged);
+    if (keepBottom)
+    {
+        scrollToAnchor(anchor);
+    }
 
     adjustLoadedItems();
     QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
 }
 
-void ListViewPriv::clear()
+void ListViewPriv::beginBatch()
 {
-    if (emptyView)
+    if (batchDepth++ == 0)
     {
-        delete emptyView;
-        emptyView = nullptr;
+        batchAnchor = captureAnchor();
+        batchChanged = false;
     }
+}
 
-    for (auto& headerView : headerViews)
+void ListViewPriv::endBatch()
+{
+    Q_ASSERT(batchDepth > 0);
+    if (--batchDepth == 0 && batchChanged && currentDelegate && !hasPendingChanges())
     {
-        if (headerView)
-        {
-            delete headerView;
-        }
+        relayout(batchAnchor);
+    }
+}
+
+void ListViewPriv::setSuspended(bool suspended)
+{
+    suspendRequested = suspended;
+    if (!isSuspended())
+    {
+        applyJournal();
+    }
+}
+
+bool ListViewPriv::isSuspended() const
+{
+    return suspendRequested || hidden;
+}
+
+void ListViewPriv::setHidden(bool hidden)
+{
+    this->hidden = hidden;
+    if (!isSuspended())
+    {
+        applyJournal();
+    }
+}
+
+void ListViewPriv::setModelCacheSize(int count)
+{
+    modelCacheSize = std::max(0, count);
+    while ((int)modelCache.size() > modelCacheSize)
+    {
+        dropCachedState(modelCache.back());
+    }
+}
+
+ListViewStats ListViewPriv::getStats() const
+{
+    ListViewStats result;
+#ifdef LISTVIEW_STATS
+    result = stats;
+    for (auto& pair : reusePool)
+    {
+        result.reusePoolSizes[pair.first] = pair.second.size();
+    }
+    result.reusePoolBytes = reusePoolMemory();
+#endif
+    return result;
+}
+
+void ListViewPriv::resetStats()
+{
+#ifdef LISTVIEW_STATS
+    stats = ListViewStats();
+#endif
+}
+
+void ListViewPriv::setFrameBudget(int us)
+{
+#ifdef LISTVIEW_STATS
+    frameBudgetNs = qint64(us) * 1000;
+#else
+    Q_UNUSED(us)
+#endif
+}
+
+void ListViewPriv::setStatsInterval(int ms)
+{
+#ifdef LISTVIEW_STATS
+    if (ms <= 0)
+    {
+        delete statsTimer;
+        statsTimer = nullptr;
+        return;
+    }
+    if (!statsTimer)
+    {
+        statsTimer = new QTimer(owner);
+        statsTimer->callOnTimeout(owner, [=]{emit owner->statsUpdated(getStats());});
+    }
+    statsTimer->start(ms);
+#else
+    Q_UNUSED(ms)
+#endif
+}
+
+void ListViewPriv::clear()
+{
+    if (emptyView)
+    {
+        delete emptyView;
+        emptyView = nullptr;
     }
-    headerViews.clear();
 
     for (auto& item : loadedItems)
     {
         if (item.index.item != ListIndex::InvalidItemIndex)
         {
             // put item views to reuse pool
-            item.view->owner->hide();
-            reusePool[item.view->owner->metaObject()].push_back(item.view);
+            recycleLoadedItem(item);
         }
     }
     loadedItems.clear();
+
+    for (auto& headerView : headerViews)
+    {
+        if (headerView)
+        {
+            delete headerView;
+        }
+    }
+    headerViews.clear();
+    collapsedGroups.clear();
+
     selected.clear();
-    groupHeights.clear();
-    itemHeights.clear();
-    contentHeight = 0;
+    detachHeights();
+    journal.clear();
+    reloadOnResume = false;
+    layout->clear();
 
     scrollArea->verticalScrollBar()->disconnect(owner);
     scrollContent->resize(owner->width(), owner->height());
@@ -696,23 +969,119 @@ void ListViewPriv::clear()
 
 void ListViewPriv::reload()
 {
+    LISTVIEW_TRACE_SCOPE("reload");
     if (!currentModel || !currentDelegate)
     {
         return;
     }
 
+    layout->setWidth(owner->width());
+    ListLayoutSnapshot snapshot;
+    const auto restored = takeSnapshot(snapshot);
     cacheHeaders();
-    cacheHeightsAndAnchorPos();
+    cacheHeights(restored ? &snapshot : nullptr);
     fixContentSize(false);
+    if (restored)
+    {
+        // 直接回到快照保存时的位置
+        ScrollAnchor anchor;
+        anchor.index = ListIndex(snapshot.header.anchorGroup, snapshot.header.anchorItem);
+        anchor.distance = snapshot.header.anchorDistance;
+        anchor.fromBottom = snapshot.header.anchorFromBottom;
+        anchor.bottom = snapshot.header.anchorBottom;
+        relayout(anchor);
+        return;
+    }
+    if (anchorMode == ListView::AnchorBottom)
+    {
+        auto vs = scrollArea->verticalScrollBar();
+        vs->disconnect(owner);
+        vs->setValue(vs->maximum());
+        QObject::connect(vs, &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
+    }
     adjustLoadedItems();
 }
 
+QByteArray ListViewPriv::saveSnapshot()
+{
+    if (!currentModel || !currentDelegate)
+    {
+        return QByteArray();
+    }
+    applyJournal();
+
+    const auto widthDependent = currentDelegate->canItemHeightAffectedByWidth();
+    const auto anchor = captureAnchor();
+    ListLayoutSnapshot snapshot;
+    auto& header = snapshot.header;
+    header = ListLayoutSnapshot::Header();
+    header.contentVersion = currentModel->owner->contentVersion();
+    header.keyHash = qHash(currentDelegate->heightCacheKey());
+    header.mode = widthDependent ? int(layoutMode) : -1;
+    header.width = widthDependent ? owner->width() : -1;
+    header.anchorGroup = anchor.index.group;
+    header.anchorItem = anchor.index.item;
+    header.anchorDistance = anchor.distance;
+    header.anchorFromBottom = anchor.fromBottom;
+    header.anchorBottom = anchor.bottom;
+    return snapshot.encode(heights->itemHeights);
+}
+
+void ListViewPriv::restoreSnapshot(const QByteArray &data)
+{
+    pendingSnapshot = data;
+    if (currentModel && currentDelegate)
+    {
+        auto selection = selected;
+        auto collapsed = collapsedGroups;
+        clear();
+        selected = selection;
+        collapsedGroups = collapsed;
+        reload();
+    }
+}
+
+bool ListViewPriv::takeSnapshot(ListLayoutSnapshot &snapshot)
+{
+    if (pendingSnapshot.isEmpty())
+    {
+        return false;
+    }
+    const auto data = pendingSnapshot;
+    pendingSnapshot = QByteArray();
+    if (!snapshot.decode(data))
+    {
+        return false;
+    }
+
+    // 快照只在数据内容、delegate 与测量宽度都与保存时相同时可用
+    auto model = currentModel->owner;
+    const auto widthDependent = currentDelegate->canItemHeightAffectedByWidth();
+    const auto& header = snapshot.header;
+    if (header.contentVersion == 0 || header.contentVersion != model->contentVersion()
+            || header.keyHash != qHash(currentDelegate->heightCacheKey())
+            || header.mode != (widthDependent ? int(layoutMode) : -1)
+            || header.width != (widthDependent ? owner->width() : -1)
+            || header.groupCount != model->numGroups())
+    {
+        return false;
+    }
+    for (int group = 0; group < header.groupCount; group++)
+    {
+        if (snapshot.itemCount(group) != model->numItemsInGroup(group))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ListViewPriv::cacheHeaders()
 {
     const auto nGroups = currentModel->owner->numGroups();
-    headerViews.reserve(nGroups);
     for (auto group = 0; group < nGroups; group++)
     {
+        LISTVIEW_TRACE_SCOPE("delegate.headerViewForGroup");
         auto view = currentDelegate->headerViewForGroup(group);
         if (view)
         {
@@ -720,46 +1089,105 @@ void ListViewPriv::cacheHeaders()
         }
         headerViews.push_back(view);
     }
+    // 切换布局方式时保留了折叠状态，此时数目不变
+    collapsedGroups.resize(nGroups, false);
 }
 
-int ListViewPriv::cacheHeightsAndAnchorPos(const ListIndex& anchorIndex)
+void ListViewPriv::cacheHeights(const ListLayoutSnapshot* snapshot)
 {
-    int anchorY = 0;
-    const auto width = owner->width();
-    const auto nGroups = currentModel->owner->numGroups();
-    groupHeights.resize(nGroups);
-    itemHeights.resize(nGroups);
-    contentHeight = 0;
-    for (auto group = 0; group < nGroups; group++)
+    LISTVIEW_TRACE_SCOPE("cacheHeights");
+    attachHeights();
+    // 共享的缓存已被其他视图测量到数据模型的当前状态时直接使用
+    if (heights->serial != currentModel->changeSerial && snapshot)
     {
-        auto& groupHeight = groupHeights[group];
-        groupHeight = 0;
-        if (anchorIndex == ListIndex(group))
+        LISTVIEW_TRACE_SCOPE("restoreSnapshot");
+        if (snapshot->fillHeights(heights->itemHeights))
         {
-            anchorY = contentHeight;
+            heights->serial = currentModel->changeSerial;
         }
-        auto headerView = headerViews[group];
-        auto headerHeight = headerView ? headerView->height() : 0;
-        groupHeight += headerHeight;
-
-        const auto nItems = currentModel->owner->numItemsInGroup(group);
-        auto& groupItemHeights = itemHeights[group];
-        groupItemHeights.resize(nItems);
-        for (auto item = 0; item < nItems; item++)
+    }
+    // 没有快照或快照中的高度无效时重新测量
+    if (heights->serial != currentModel->changeSerial)
+    {
+        const auto nGroups = currentModel->owner->numGroups();
+        heights->itemHeights.resize(nGroups);
+        for (auto group = 0; group < nGroups; group++)
         {
-            if (anchorIndex == ListIndex(group, item))
+            const auto nItems = currentModel->owner->numItemsInGroup(group);
+            const auto width = layout->itemWidth(group);
+            auto& groupItemHeights = heights->itemHeights[group];
+            groupItemHeights.resize(nItems);
+            prepareHeights(group, 0, nItems, width);
+            for (auto item = 0; item < nItems; item++)
             {
-                anchorY = contentHeight + groupHeight;
+                groupItemHeights[item] = measureHeight(ListIndex(group, item), width);
             }
-            auto itemHeight = currentDelegate->heightForIndex(ListIndex(group, item), width);
-            groupItemHeights[item] = itemHeight;
-            groupHeight += itemHeight;
         }
+        heights->serial = currentModel->changeSerial;
+    }
+    // TODO: 这里可能需要做加法溢出判断，如果有溢出，则修改加载逻辑，不加载任何东西~
+    rebuildLayout();
+}
+
+void ListViewPriv::attachHeights()
+{
+    const auto widthDependent = currentDelegate->canItemHeightAffectedByWidth();
+    // 先获取再归还，宽度不变时不会因为引用计数归零而丢弃仍然有效的缓存
+    auto store = currentModel->acquireHeights(currentDelegate->heightCacheKey(),
+                                              widthDependent ? int(layoutMode) : -1,
+                                              widthDependent ? owner->width() : -1);
+    detachHeights();
+    heights = store;
+}
+
+void ListViewPriv::detachHeights()
+{
+    if (heights != &localHeights)
+    {
+        currentModel->releaseHeights(heights);
+        heights = &localHeights;
+    }
+}
+
+bool ListViewPriv::claimHeights()
+{
+    if (heights->serial == currentModel->changeSerial)
+    {
+        return false;
+    }
+    heights->serial = currentModel->changeSerial;
+    return true;
+}
 
-        // TODO: 这里可能需要做加法溢出判断，如果有溢出，则修改加载逻辑，不加载任何东西~
-        contentHeight += groupHeight;
+void ListViewPriv::rebuildLayout()
+{
+    LISTVIEW_TRACE_SCOPE("rebuildLayout");
+    layout->clear();
+    const auto nGroups = (int)heights->itemHeights.size();
+    for (int group = 0; group < nGroups; group++)
+    {
+        layout->insertGroup(group, headerHeight(group), heights->itemHeights[group], collapsedGroups[group]);
     }
-    return anchorY;
+}
+
+ListLayoutEngine *ListViewPriv::createLayout(ListView::LayoutMode mode)
+{
+    ListLayoutEngine* result;
+    switch (mode)
+    {
+    case ListView::GridLayout:
+        result = new ListGridLayout();
+        break;
+    case ListView::MasonryLayout:
+        result = new ListMasonryLayout();
+        break;
+    default:
+        result = new ListVerticalLayout();
+        break;
+    }
+    result->setDelegate(currentDelegate);
+    result->setWidth(owner->width());
+    return result;
 }
 
 void ListViewPriv::setupEmptyView()
@@ -792,473 +1220,1036 @@ void ListViewPriv::clearEmptyView()
 
 void ListViewPriv::adjustLoadedItems()
 {
-    if (!currentDelegate)
+    if (!currentDelegate || hasPendingChanges())
     {
+        // 有尚未应用的修改时布局与数据模型不一致，恢复之前不加载视图
         return;
     }
 
+    LISTVIEW_STATS_PASS();
+    LISTVIEW_TRACE_SCOPE("adjustLoadedItems");
+
     if (modelNotEmpty())
     {
         clearEmptyView();
-        unloadOutOfViewportItems();
-        loadUnderItems();
-        loadAboveItems();
-        recyclePreloadedItems();
+        adjustVisibleItems();
+        scheduleFetch();
     }
     else
     {
         setupEmptyView();
     }
+
+    if (visibleRangeTimer && !visibleRangeTimer->isActive())
+    {
+        visibleRangeTimer->start(ListViewRangeInterval);
+    }
 }
 
 void ListViewPriv::fixContentSize(bool widthChanged)
 {
+    LISTVIEW_TRACE_SCOPE("fixContentSize");
     auto width = owner->width();
 
     if (!widthChanged)
     {
-        scrollContent->resize(width, contentHeight);
+        scrollContent->resize(width, layout->contentHeight());
         return;
     }
 
+    layout->setWidth(width);
     if (!currentModel || !currentDelegate)
     {
         return;
     }
 
+    // 在重新计算布局并调整 scrollContent 高度之后，滚动视图使锚点视图在视口中保持其原来的位置。
+    // 选取锚点的方法是：未滚动到底部时以第一个（底部锚定时为最后一个） item 作为锚点，已滚动到底部时保持在底部
+    auto anchor = captureAnchor();
+    auto vs = scrollArea->verticalScrollBar();
+    anchor.bottom = vs->value() == vs->maximum();
+
     if (currentDelegate->canItemHeightAffectedByWidth())
     {
-        // 在 contentHeight 计算完成并调整 scrollContent 高度之后，需要将所有已加载的数据项视图调整到正确的Y轴位置
-        // 在此之前记录锚点视图，并记录其到视口顶点的距离
-        // 然后滚动视图，可以使锚点视图在视口中保持其原来的位置。
-        // 选取锚点的方法是：未滚动到底部时以第一个 item 的顶部作为锚点，已滚动到底部时以最后一个 item 的底部作为锚点
-        ListIndex anchorIndex;
-        int anchorDistance;
+        cacheHeights();
+    }
+    else if (layout->dependsOnWidth())
+    {
+        rebuildLayout();
+    }
+    scrollContent->resize(width, layout->contentHeight());
 
-        auto vs = scrollArea->verticalScrollBar();
-        auto viewportTop = vs->value();
-        auto anchorIsTop = viewportTop != vs->maximum();
+    if (layout->contentHeight() != scrollContent->height())
+    {
+        // The contentHeight is too large... ( > QWIDGETSIZE_MAX)
+    }
 
-        if (!loadedItems.empty())
-        {
-            if (anchorIsTop)
-            {
-                anchorIndex = loadedItems.front().index;
-                anchorDistance = loadedItems.front().y - viewportTop;
-            }
-            else
-            {
-                anchorIndex = loadedItems.back().index;
-                // 此处可确定已滚动到底部，最后一个 item 底部到 viewport 底部距离为 0
-                anchorDistance = 0;
-            }
-        }
+    scrollToAnchor(anchor);
+}
+
+void ListViewPriv::adjustVisibleItems()
+{
+    LISTVIEW_TRACE_SCOPE("adjustVisibleItems");
+    const auto viewportTop = scrollArea->verticalScrollBar()->value();
+    const auto viewportBottom = viewportTop + scrollArea->height();
 
-        const auto newAnchorY = cacheHeightsAndAnchorPos(anchorIndex);
-        scrollContent->resize(width, contentHeight);
+    std::vector<ListIndex> visibleIndexes;
+    layout->indexesInRange(viewportTop, viewportBottom, visibleIndexes);
 
-        if (contentHeight != scrollContent->height())
+    // visibleIndexes 与 loadedItems 都是有序的，合并两者：
+    // 仍然可见的项原地复用，不再可见的项回收，新出现的项优先从 pendingItems 中取，否则生成新视图
+    std::list<LoadedItem> previousItems;
+    previousItems.swap(loadedItems);
+    auto previousIt = previousItems.begin();
+    for (auto& index : visibleIndexes)
+    {
+        while (previousIt != previousItems.end() && previousIt->index < index)
         {
-            // The contentHeight is too large... ( > QWIDGETSIZE_MAX)
+            recycleLoadedItem(*previousIt);
+            previousIt++;
         }
 
-        if (loadedItems.empty())
+        LoadedItem item = {index, layout->itemRect(index), nullptr};
+        auto pendingIt = pendingItems.find(index);
+        if (previousIt != previousItems.end() && previousIt->index == index)
         {
-            return;
+            item.view = previousIt->view;
+            previousIt++;
+        }
+        else if (pendingIt != pendingItems.end())
+        {
+            item.view = pendingIt->second.view;
+            pendingItems.erase(pendingIt);
+        }
+        else if (!index.isHeader())
+        {
+            item.view = generateItemView(index, item.rect);
         }
 
-        // 调整 loadedItems 的位置
-        if (anchorIsTop)
+        QWidget* view = index.isHeader() ? headerViews[index.group] : item.view->owner;
+        if (view)
         {
-            // 以第一个 item 的顶部作为锚点，向下依次调整
-            auto currentY = newAnchorY;
-            for (auto it = loadedItems.begin(); it != loadedItems.end(); it++)
-            {
-                auto& item = *it;
-                item.h = item.index.item == ListIndex::InvalidItemIndex
-                        ? headerHeight(item.index.group)
-                        : itemHeights[item.index.group][item.index.item];
-                item.y = currentY;
+            view->setGeometry(item.rect);
+            view->show();
+        }
+        loadedItems.push_back(item);
+    }
 
-                QWidget* view = (item.index.item == ListIndex::InvalidItemIndex)
-                        ? headerViews[item.index.group]
-                        : item.view->owner;
+    for (; previousIt != previousItems.end(); previousIt++)
+    {
+        recycleLoadedItem(*previousIt);
+    }
+    recyclePreloadedItems();
+}
 
-                if (view)
-                {
-                    view->setGeometry(0, item.y, width, item.h);
-                }
+void ListViewPriv::relayout(const ScrollAnchor &anchor)
+{
+    auto vs = scrollArea->verticalScrollBar();
+    vs->disconnect(owner);
+    scrollContent->resize(owner->width(), layout->contentHeight());
+    // 锚点是修改前记录的，按正在进行的修改换算为修改后的索引
+    auto remapped = anchor;
+    remapped.index = remapIndex(anchor.index);
+    scrollToAnchor(remapped);
+    QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
+    adjustLoadedItems();
+}
 
-                currentY = item.y + item.h;
-            }
-            vs->setValue(newAnchorY - anchorDistance);
-        }
-        else
-        {
-            // 以最后一个 item 的底部作为锚点，向上依次调整
-            auto currentY = contentHeight;
-            for (auto it = loadedItems.rbegin(); it != loadedItems.rend(); it++)
-            {
-                auto& item = *it;
-                item.h = item.index.item == ListIndex::InvalidItemIndex
-                        ? headerHeight(item.index.group)
-                        : itemHeights[item.index.group][item.index.item];
-                item.y = currentY - item.h;
+void ListViewPriv::finishModify()
+{
+    if (batchDepth == 0)
+    {
+        relayout(modifyInfo.anchor);
+        return;
+    }
 
-                QWidget* view = (item.index.item == ListIndex::InvalidItemIndex)
-                        ? headerViews[item.index.group]
-                        : item.view->owner;
+    // 留在 loadedItems 中的项都在修改位置之前，pendingItems 中的项都在其后，直接接在末尾即可保持有序。
+    // 视图的位置在批量修改结束时由 adjustVisibleItems 统一更新
+    batchAnchor.index = remapIndex(batchAnchor.index);
+    batchChanged = true;
+    for (auto& pair : pendingItems)
+    {
+        loadedItems.push_back(pair.second);
+    }
+    pendingItems.clear();
+}
 
-                if (view)
-                {
-                    view->setGeometry(0, item.y, width, item.h);
-                }
+void ListViewPriv::scrollToAnchor(const ScrollAnchor &anchor)
+{
+    auto vs = scrollArea->verticalScrollBar();
+    if (anchor.bottom)
+    {
+        vs->setValue(vs->maximum());
+        return;
+    }
 
-                currentY = item.y;
-            }
-            auto maxScrollValue = vs->maximum();
-            vs->setValue(maxScrollValue);
-        }
+    auto index = anchor.index;
+    if (!index.isEmpty() && !isValidIndex(index))
+    {
+        // 锚点所在位置已被删除，改用下一个分组的开头
+        index = index.group + 1 < (int)heights->itemHeights.size() ? ListIndex(index.group + 1) : ListIndex();
+    }
+    if (!isValidIndex(index))
+    {
+        return;
+    }
+
+    const auto rect = layout->itemRect(index);
+    if (anchor.fromBottom)
+    {
+        vs->setValue(rect.y() + rect.height() + anchor.distance - scrollArea->height());
     }
     else
     {
-        // change the loaded item's width
-        for (auto& item : loadedItems)
-        {
-            QWidget* view = (item.index.item == ListIndex::InvalidItemIndex)
-                    ? headerViews[item.index.group]
-                    : item.view->owner;
+        vs->setValue(rect.y() - anchor.distance);
+    }
+}
 
-            if (view)
-            {
-                view->setGeometry(0, item.y, width, item.h);
-            }
+ListViewPriv::ScrollAnchor ListViewPriv::captureAnchor()
+{
+    ScrollAnchor result;
+    auto vs = scrollArea->verticalScrollBar();
+    if (anchorMode == ListView::AnchorBottom)
+    {
+        // 底部锚定：以最后一个已加载项的底部为锚点，只有视口位于底部时才继续跟随新内容
+        result.bottom = vs->value() >= vs->maximum();
+        result.fromBottom = true;
+        if (!loadedItems.empty())
+        {
+            const auto& rect = loadedItems.back().rect;
+            result.index = loadedItems.back().index;
+            result.distance = vs->value() + scrollArea->height() - (rect.y() + rect.height());
         }
+        return result;
+    }
 
-        scrollContent->resize(width, contentHeight);
+    if (!loadedItems.empty())
+    {
+        result.index = loadedItems.front().index;
+        result.distance = loadedItems.front().rect.y() - vs->value();
     }
+    return result;
 }
 
-void ListViewPriv::loadAboveItems()
+void ListViewPriv::setGroupCollapsed(int group, bool collapsed)
 {
-    const auto viewportTop = scrollArea->verticalScrollBar()->value();
-    const auto viewportBottom = viewportTop + scrollArea->height();
-    const auto width = owner->width();
-
-    auto nextIndex = loadedItems.empty() ? currentModel->owner->maxIndex() : decreaseIndex(loadedItems.front().index);
-
-    if (nextIndex.isEmpty())
+    applyJournal();
+    if (!currentModel || !currentDelegate || group < 0 || group >= (int)collapsedGroups.size())
+    {
+        return;
+    }
+    if (collapsedGroups[group] == collapsed)
     {
         return;
     }
 
-    int nextHeight = nextIndex.item == ListIndex::InvalidItemIndex
-            ? headerHeight(nextIndex.group)
-            : itemHeights[nextIndex.group][nextIndex.item];
+    // 锚点在被折叠的分组内时改为以分组头为锚点，分组头保持在视口中原来的位置
+    auto anchor = captureAnchor();
+    if (collapsed && anchor.index.group == group && !anchor.index.isHeader())
+    {
+        anchor.index = ListIndex(group);
+        anchor.distance = layout->itemRect(anchor.index).y() - scrollArea->verticalScrollBar()->value();
+        anchor.fromBottom = false;
+    }
+
+    // 高度缓存与数据项的布局都保留，只修改该分组在位置索引中的总高度
+    collapsedGroups[group] = collapsed;
+    layout->setCollapsed(group, collapsed);
+    relayout(anchor);
+    emit owner->groupCollapsedChanged(group, collapsed);
+}
 
-    auto nextY = loadedItems.empty()
-            ? viewportBottom - nextHeight
-            : loadedItems.front().y - nextHeight;
+bool ListViewPriv::isGroupCollapsed(int group) const
+{
+    return group >= 0 && group < (int)collapsedGroups.size() && collapsedGroups[group];
+}
 
-    // Load items to fill the viewport
-    while (nextY + nextHeight > viewportTop)
+void ListViewPriv::shiftLoadedItems()
+{
+    while (!loadedItems.empty() && loadedItems.back().index >= modifyInfo.index)
     {
-        // Ensure this item is in the viewport
-        if (nextY <= viewportBottom)
+        auto& item = loadedItems.back();
+        if (isRemovedIndex(item.index))
         {
-            // make this item or header visible
-            if (nextIndex.item == ListIndex::InvalidItemIndex)
-            {
-                auto& headerView = headerViews[nextIndex.group];
-                if (headerView)
-                {
-                    headerView->setGeometry(0, nextY, width, nextHeight);
-                    headerView->show();
-                }
-                loadedItems.push_front({nextIndex, nextY, nextHeight, nullptr});
-            }
-            else
+            // This item has been removed, now recycle the view.
+            recycleLoadedItem(item);
+        }
+        else
+        {
+            item.index = remapIndex(item.index);
+            if (item.view)
             {
-                auto pendingIt = pendingItems.find(nextIndex);
-                if (pendingIt != pendingItems.end())
-                {
-                    auto& item = pendingIt->second;
-                    Q_ASSERT(item.y == nextY);
-                    Q_ASSERT(item.h == nextHeight);
-                    loadedItems.push_front(item);
-                }
-                else
-                {
-                    auto view = generateItemView(nextIndex, nextY, nextHeight);
-                    loadedItems.push_front({nextIndex, nextY, nextHeight, view});
-                }
+                item.view->index = item.index;
             }
+            pendingItems[item.index] = item;
         }
+        loadedItems.pop_back();
+    }
+}
 
-        // calculate next item's index, y and height
-        nextIndex = decreaseIndex(nextIndex);
-        if (nextIndex.isEmpty())
+void ListViewPriv::shiftSelection()
+{
+    // 选中列表是有序的，只需调整 modifyInfo.index 之后的部分；修改数据项时只影响同一分组
+    const auto itemsOnly = modifyInfo.mode == ModifyModeInsertItem || modifyInfo.mode == ModifyModeRemoveItem;
+    auto selectedIt = std::lower_bound(selected.begin(), selected.end(), modifyInfo.index);
+    while (selectedIt != selected.end())
+    {
+        if (itemsOnly && selectedIt->group != modifyInfo.index.group)
         {
-            return;
+            break;
         }
-        if (nextIndex.item == ListIndex::InvalidItemIndex)
+        if (isRemovedIndex(*selectedIt))
         {
-            auto& headerView = headerViews[nextIndex.group];
-            nextHeight = headerView ? headerView->height() : 0;
+            selectedIt = selected.erase(selectedIt);
         }
         else
         {
-            nextHeight = itemHeights[nextIndex.group][nextIndex.item];
+            *selectedIt = remapIndex(*selectedIt);
+            selectedIt++;
         }
-        nextY -= nextHeight;
     }
 }
 
-void ListViewPriv::loadUnderItems()
+bool ListViewPriv::hasPendingChanges() const
 {
-    const auto viewportTop = scrollArea->verticalScrollBar()->value();
-    const auto viewportBottom = viewportTop + scrollArea->height();
-    const auto width = owner->width();
+    return reloadOnResume || !journal.empty();
+}
 
-    auto nextIndex = loadedItems.empty() ? ListIndex(0, ListIndex::InvalidItemIndex) : increaseIndex(loadedItems.back().index);
+bool ListViewPriv::journalChange()
+{
+    if (!isSuspended())
+    {
+        return false;
+    }
+    if (!reloadOnResume)
+    {
+        if ((int)journal.size() < ListViewJournalLimit)
+        {
+            journal.push_back({modifyInfo.mode, modifyInfo.index, modifyInfo.count, currentModel->changeSerial});
+        }
+        else
+        {
+            journal.clear();
+            reloadOnResume = true;
+        }
+    }
+    return true;
+}
 
-    if (nextIndex.isEmpty())
+void ListViewPriv::applyJournal()
+{
+    if (reloadOnResume)
     {
+        LISTVIEW_TRACE_SCOPE("resumeReload");
+        auto selection = selected;
+        clear();
+        selected = selection;
+        reload();
         return;
     }
+    if (!journal.empty())
+    {
+        replayJournal(captureAnchor());
+    }
+}
 
-    auto nextY = loadedItems.empty() ? 0 : loadedItems.back().y + loadedItems.back().h;
-    auto nextHeight = nextIndex.item == ListIndex::InvalidItemIndex
-            ? headerHeight(nextIndex.group)
-            : itemHeights[nextIndex.group][nextIndex.item];
-
-    while (!nextIndex.isEmpty() && nextY < viewportBottom)
+void ListViewPriv::replayJournal(ScrollAnchor anchor)
+{
+    LISTVIEW_TRACE_SCOPE("replayJournal");
+    // 锚点与已加载项的索引都是记录修改之前的，锚点随修改记录换算，已加载的视图全部回收后重新加载
+    for (auto& item : loadedItems)
     {
-        if (nextY + nextHeight >= viewportTop)
+        recycleLoadedItem(item);
+    }
+    loadedItems.clear();
+
+    // 共享的高度缓存可能已被其他视图更新到某条修改之后，只重放缓存尚未应用的修改。
+    // 重放时的索引是修改发生时的索引，不能向 delegate 测量，新数据项先记为 -1 ，全部重放之后再按最终的索引测量
+    const auto applied = heights->serial;
+    auto& itemHeights = heights->itemHeights;
+    std::set<int> dirtyGroups;
+    std::set<int> newGroups;
+    std::set<int> newHeaders;
+    auto shiftGroups = [](std::set<int>& groups, int group, int delta)
+    {
+        std::set<int> result;
+        for (auto g : groups)
         {
-            auto pendingIt = pendingItems.find(nextIndex);
-            if (nextIndex.item == ListIndex::InvalidItemIndex)
+            if (g < group)
             {
-                auto& headerView = headerViews[nextIndex.group];
-                if (headerView)
-                {
-                    headerView->setGeometry(0, nextY, width, nextHeight);
-                    headerView->show();
-                }
-                loadedItems.push_back({nextIndex, nextY, nextHeight, nullptr});
+                result.insert(g);
             }
-            else
+            else if (delta > 0 || g > group)
             {
-                if (pendingIt != pendingItems.end())
+                result.insert(g + delta);
+            }
+        }
+        groups.swap(result);
+    };
+
+    for (auto& entry : journal)
+    {
+        modifyInfo.mode = entry.mode;
+        modifyInfo.index = entry.index;
+        modifyInfo.count = entry.count;
+        anchor.index = remapIndex(anchor.index);
+
+        const auto group = entry.index.group;
+        const auto apply = entry.serial > applied;
+        switch (entry.mode)
+        {
+        case ModifyModeUpdateItem:
+        case ModifyModeInsertItem:
+            if (apply && !newGroups.count(group))
+            {
+                auto& groupItemHeights = itemHeights[group];
+                if (entry.mode == ModifyModeUpdateItem)
                 {
-                    auto& item = pendingIt->second;
-                    Q_ASSERT(item.y == nextY);
-                    Q_ASSERT(item.h == nextHeight);
-                    loadedItems.push_back(item);
+                    std::fill(groupItemHeights.begin() + entry.index.item, groupItemHeights.begin() + entry.index.item + entry.count, -1);
                 }
                 else
                 {
-                    auto view = generateItemView(nextIndex, nextY, nextHeight);
-                    loadedItems.push_back({nextIndex, nextY, nextHeight, view});
+                    groupItemHeights.insert(groupItemHeights.begin() + entry.index.item, entry.count, -1);
                 }
+                dirtyGroups.insert(group);
+            }
+            break;
+        case ModifyModeRemoveItem:
+            if (apply && !newGroups.count(group))
+            {
+                auto& groupItemHeights = itemHeights[group];
+                groupItemHeights.erase(groupItemHeights.begin() + entry.index.item, groupItemHeights.begin() + entry.index.item + entry.count);
+            }
+            break;
+        case ModifyModeInsertGroup:
+            headerViews.insert(headerViews.begin() + group, nullptr);
+            collapsedGroups.insert(collapsedGroups.begin() + group, false);
+            shiftGroups(newHeaders, group, 1);
+            newHeaders.insert(group);
+            if (apply)
+            {
+                // 新分组的数据项数目只有在重放结束后才能确定，整个分组最后再测量
+                itemHeights.insert(itemHeights.begin() + group, ListHeights());
+                shiftGroups(dirtyGroups, group, 1);
+                shiftGroups(newGroups, group, 1);
+                newGroups.insert(group);
             }
-            if (pendingIt != pendingItems.end())
+            break;
+        case ModifyModeRemoveGroup:
+            delete headerViews[group];
+            headerViews.erase(headerViews.begin() + group);
+            collapsedGroups.erase(collapsedGroups.begin() + group);
+            shiftGroups(newHeaders, group, -1);
+            if (apply)
             {
-                pendingItems.erase(pendingIt);
+                itemHeights.erase(itemHeights.begin() + group);
+                shiftGroups(dirtyGroups, group, -1);
+                shiftGroups(newGroups, group, -1);
             }
+            break;
         }
+    }
+    modifyInfo.mode = ModifyModeNone;
+    journal.clear();
 
-        nextIndex = increaseIndex(nextIndex);
-        if (nextIndex.isEmpty())
+    for (auto group : newHeaders)
+    {
+        auto view = currentDelegate->headerViewForGroup(group);
+        if (view)
         {
-            return;
+            view->setParent(scrollContent);
         }
-        nextY += nextHeight;
-        if (nextIndex.item == ListIndex::InvalidItemIndex)
+        headerViews[group] = view;
+    }
+    for (auto group : newGroups)
+    {
+        const auto width = layout->itemWidth(group);
+        auto& groupItemHeights = itemHeights[group];
+        groupItemHeights.resize(currentModel->owner->numItemsInGroup(group));
+        prepareHeights(group, 0, (int)groupItemHeights.size(), width);
+        for (int item = 0; item < (int)groupItemHeights.size(); item++)
         {
-            auto& headerView = headerViews[nextIndex.group];
-            nextHeight = headerView ? headerView->height() : 0;
+            groupItemHeights[item] = measureHeight(ListIndex(group, item), width);
         }
-        else
+    }
+    for (auto group : dirtyGroups)
+    {
+        if (newGroups.count(group))
+        {
+            continue;
+        }
+        const auto width = layout->itemWidth(group);
+        auto& groupItemHeights = itemHeights[group];
+        for (int item = 0; item < (int)groupItemHeights.size(); item++)
         {
-            nextHeight = itemHeights[nextIndex.group][nextIndex.item];
+            if (groupItemHeights[item] < 0)
+            {
+                groupItemHeights[item] = measureHeight(ListIndex(group, item), width);
+            }
         }
     }
+    heights->serial = currentModel->changeSerial;
+
+    rebuildLayout();
+    relayout(anchor);
 }
 
-void ListViewPriv::unloadOutOfViewportItems()
+void ListViewPriv::stashModelState()
 {
-    auto isOutOfViewport = [](int y, int h, int viewportTop, int viewportBottom)
+    if (modelCacheSize == 0 || !currentModel || !currentDelegate || heights == &localHeights)
     {
-        return y > viewportBottom || y + h < viewportTop;
-    };
-    auto vTop = scrollArea->verticalScrollBar()->value();
-    auto vBottom = vTop + scrollArea->height();
-    for (auto it = loadedItems.begin(); it != loadedItems.end(); )
+        return;
+    }
+
+    LISTVIEW_TRACE_SCOPE("stashModelState");
+    auto state = new CachedState();
+    state->view = this;
+    state->model = currentModel;
+    state->width = owner->width();
+    state->anchor = captureAnchor();
+
+    // 分组头视图随状态一起保存，先回收已加载项，clear 之后不再访问它们
+    for (auto& item : loadedItems)
     {
-        auto& item = *it;
-        if (isOutOfViewport(item.y, item.h, vTop, vBottom))
-        {
-            if (item.index.item == ListIndex::InvalidItemIndex)
-            {
-                if (auto& view = headerViews[item.index.group])
-                {
-                    view->hide();
-                }
-            }
-            else
-            {
-                item.view->owner->hide();
-                reusePool[item.view->owner->metaObject()].push_back(item.view);
-            }
+        recycleLoadedItem(item);
+    }
+    loadedItems.clear();
 
-            it = loadedItems.erase(it);
-        }
-        else
+    state->heights = heights;
+    heights = &localHeights;
+    state->layout = layout;
+    layout = createLayout(layoutMode);
+    state->headerViews.swap(headerViews);
+    state->collapsedGroups.swap(collapsedGroups);
+    state->selected.swap(selected);
+    state->journal.swap(journal);
+    state->selectionShifted = state->journal.size();
+    state->reloadRequired = reloadOnResume;
+    reloadOnResume = false;
+
+    currentModel->observers.insert(state);
+    modelCache.push_front(state);
+    while ((int)modelCache.size() > modelCacheSize)
+    {
+        dropCachedState(modelCache.back());
+    }
+}
+
+bool ListViewPriv::restoreModelState()
+{
+    if (!currentModel || !currentDelegate)
+    {
+        return false;
+    }
+    auto it = std::find_if(modelCache.begin(), modelCache.end(), [this](CachedState* state){return state->model == currentModel;});
+    if (it == modelCache.end())
+    {
+        return false;
+    }
+    auto state = *it;
+    if (state->width != owner->width())
+    {
+        dropCachedState(state);
+        return false;
+    }
+
+    LISTVIEW_TRACE_SCOPE("restoreModelState");
+    modelCache.erase(it);
+    currentModel->observers.erase(state);
+
+    detachHeights();
+    heights = state->heights;
+    delete layout;
+    layout = state->layout;
+    layout->setWidth(owner->width());
+    headerViews.swap(state->headerViews);
+    collapsedGroups.swap(state->collapsedGroups);
+    selected.swap(state->selected);
+    journal.swap(state->journal);
+    reloadOnResume = state->reloadRequired;
+    const auto anchor = state->anchor;
+    const auto selectionShifted = state->selectionShifted;
+    delete state;
+
+    // 选中列表按保存期间的修改记录调整，保存之前暂停期间的修改已经调整过
+    for (auto it = journal.begin() + std::min(selectionShifted, journal.size()); it != journal.end(); it++)
+    {
+        const auto& entry = *it;
+        if (entry.mode != ModifyModeUpdateItem)
         {
-            it++;
+            modifyInfo.mode = entry.mode;
+            modifyInfo.index = entry.index;
+            modifyInfo.count = entry.count;
+            shiftSelection();
         }
     }
+    modifyInfo.mode = ModifyModeNone;
+
+    if (reloadOnResume)
+    {
+        applyJournal();
+    }
+    else if (!journal.empty())
+    {
+        replayJournal(anchor);
+    }
+    else
+    {
+        relayout(anchor);
+    }
+    return true;
+}
+
+void ListViewPriv::dropCachedState(CachedState *state)
+{
+    modelCache.remove(state);
+    state->model->observers.erase(state);
+    state->model->releaseHeights(state->heights);
+    for (auto view : state->headerViews)
+    {
+        delete view;
+    }
+    delete state->layout;
+    delete state;
+}
+
+void ListViewPriv::clearModelCache()
+{
+    while (!modelCache.empty())
+    {
+        dropCachedState(modelCache.front());
+    }
+}
+
+void ListViewPriv::CachedState::record(int mode, const ListIndex &index, int count)
+{
+    if (reloadRequired)
+    {
+        return;
+    }
+    if ((int)journal.size() < ListViewJournalLimit)
+    {
+        journal.push_back({mode, index, count, model->changeSerial});
+    }
+    else
+    {
+        journal.clear();
+        reloadRequired = true;
+    }
+}
+
+void ListViewPriv::CachedState::modelAboutToChange()
+{
+}
+
+void ListViewPriv::CachedState::modelReloaded()
+{
+    journal.clear();
+    selected.clear();
+    reloadRequired = true;
+}
+
+void ListViewPriv::CachedState::modelItemUpdated(const ListIndex &index)
+{
+    if (!index.isHeader())
+    {
+        record(ModifyModeUpdateItem, index, 1);
+    }
+}
+
+void ListViewPriv::CachedState::modelItemsUpdated(const ListIndex &first, int count)
+{
+    if (!first.isHeader())
+    {
+        record(ModifyModeUpdateItem, first, count);
+    }
+}
+
+void ListViewPriv::CachedState::modelItemsInserted(const ListIndex &index, int count)
+{
+    record(ModifyModeInsertItem, index, count);
+}
+
+void ListViewPriv::CachedState::modelItemsRemoved(const ListIndex &index, int count)
+{
+    record(ModifyModeRemoveItem, index, count);
+}
+
+void ListViewPriv::CachedState::modelGroupInserted(int group)
+{
+    record(ModifyModeInsertGroup, ListIndex(group), 1);
+}
+
+void ListViewPriv::CachedState::modelGroupRemoved(int group)
+{
+    record(ModifyModeRemoveGroup, ListIndex(group), 1);
+}
+
+void ListViewPriv::CachedState::modelBatchBegin()
+{
+}
+
+void ListViewPriv::CachedState::modelBatchEnd()
+{
+}
+
+void ListViewPriv::CachedState::modelDestroyed()
+{
+    view->dropCachedState(this);
 }
 
 void ListViewPriv::recyclePreloadedItems()
 {
     for (auto& pair : pendingItems)
     {
-        auto& index = pair.first;
-        auto& item = pair.second;
-        if (index.item == ListIndex::InvalidItemIndex)
-        {
-            if (auto& headerView = headerViews[index.group])
-            {
-                headerView->hide();
-            }
-        }
-        else
-        {
-            item.view->owner->hide();
-            reusePool[item.view->owner->metaObject()].push_back(item.view);
-        }
+        recycleLoadedItem(pair.second);
     }
     pendingItems.clear();
 }
 
-ListIndex ListViewPriv::increaseIndex(const ListIndex &index)
+ListViewRange ListViewPriv::visibleRange()
 {
-    int group, item;
-    int nItemsInGroup = (int)itemHeights[index.group].size();
-    if (index.item == nItemsInGroup - 1)
+    ListViewRange result;
+    if (!currentModel || !currentDelegate || hasPendingChanges() || !modelNotEmpty())
     {
-        int nGroups = (int)itemHeights.size();
-        if (index.group == nGroups - 1)
-        {
-            group = ListIndex::InvalidGroupIndex;
-            item = ListIndex::InvalidItemIndex;
-        }
-        else
-        {
-            // ListIndex.item = ListIndex::InvalidItemIndex 代表一个分组的索引
-            // 用于加载分组 header 视图~
-            group = index.group + 1;
-            item = ListIndex::InvalidItemIndex;
-        }
+        return result;
     }
-    else
+
+    // 只统计与视口有重叠的项，恰好接在视口边缘外的项不算可见
+    const auto viewportTop = scrollArea->verticalScrollBar()->value();
+    const auto viewportBottom = viewportTop + scrollArea->height();
+    std::vector<ListIndex> indexes;
+    layout->indexesInRange(viewportTop + 1, viewportBottom - 1, indexes);
+    if (!indexes.empty())
     {
-        group = index.group;
-        item = index.item + 1;
+        result.first = indexes.front();
+        result.last = indexes.back();
     }
-    return ListIndex(group, item);
+    return result;
 }
 
-ListIndex ListViewPriv::decreaseIndex(const ListIndex &index)
+ListIndex ListViewPriv::indexAt(const QPoint &pos)
 {
-    int group, item;
-    if (index.item == ListIndex::InvalidItemIndex)
+    if (!currentModel || !currentDelegate || hasPendingChanges())
     {
-        if (index.group == 0)
-        {
-            group = ListIndex::InvalidGroupIndex;
-            item = ListIndex::InvalidItemIndex;
-        }
-        else
-        {
-            group = index.group - 1;
-            int nItemsInGroup = (int)itemHeights[group].size();
-            item = nItemsInGroup - 1;
-        }
+        return ListIndex();
     }
-    else
+
+    const auto point = scrollContent->mapFrom(owner, pos);
+    std::vector<ListIndex> indexes;
+    layout->indexesInRange(point.y(), point.y(), indexes);
+    for (auto& index : indexes)
     {
-        group = index.group;
-        item = index.item - 1;
+        if (layout->itemRect(index).contains(point))
+        {
+            return index;
+        }
     }
-    return ListIndex(group, item);
+    return ListIndex();
 }
 
-void ListViewPriv::scrollWithoutNotify(int dy)
+QRect ListViewPriv::itemRect(const ListIndex &index)
 {
-    auto vs = scrollArea->verticalScrollBar();
-    vs->disconnect(owner);
-    vs->setValue(vs->value() + dy);
-    QObject::connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, owner, [=]{adjustLoadedItems();});
+    if (!currentModel || !currentDelegate || hasPendingChanges() || !isValidIndex(index))
+    {
+        return QRect();
+    }
+
+    const auto rect = layout->itemRect(index);
+    return QRect(scrollContent->mapTo(owner, rect.topLeft()), rect.size());
 }
 
-void ListViewPriv::adjustItem(ListViewPriv::LoadedItem &item, const ListIndex& newIndex, int y)
+void ListViewPriv::watchVisibleRange()
 {
-    item.y = y;
-    item.index = newIndex;
-    if (item.index.item == ListIndex::InvalidItemIndex)
+    if (visibleRangeTimer)
     {
-        auto& view = headerViews[item.index.group];
-        if (view)
+        return;
+    }
+    visibleRangeTimer = new QTimer(owner);
+    visibleRangeTimer->setSingleShot(true);
+    visibleRangeTimer->callOnTimeout(owner, [=]{
+        const auto range = visibleRange();
+        if (range != lastVisibleRange)
         {
-            view->move(0, y);
+            lastVisibleRange = range;
+            emit owner->visibleRangeChanged(range.first, range.last);
         }
+    });
+    visibleRangeTimer->start(ListViewRangeInterval);
+}
+
+bool ListViewPriv::isValidIndex(const ListIndex &index)
+{
+    return index.group >= 0 && index.group < (int)heights->itemHeights.size()
+            && index.item >= ListIndex::InvalidItemIndex && index.item < (int)heights->itemHeights[index.group].size();
+}
+
+ListIndex ListViewPriv::remapIndex(const ListIndex &index)
+{
+    if (index.isEmpty())
+    {
+        return index;
     }
-    else
+    const auto& modifyIndex = modifyInfo.index;
+    switch (modifyInfo.mode)
     {
-        item.view->index = newIndex;
-        item.view->owner->move(0, y);
+    case ModifyModeInsertItem:
+        if (index.group == modifyIndex.group && index.item >= modifyIndex.item)
+        {
+            return ListIndex(index.group, index.item + modifyInfo.count);
+        }
+        break;
+    case ModifyModeRemoveItem:
+        if (index.group == modifyIndex.group && index.item >= modifyIndex.item)
+        {
+            return ListIndex(index.group, std::max(modifyIndex.item, index.item - modifyInfo.count));
+        }
+        break;
+    case ModifyModeInsertGroup:
+        if (index.group >= modifyIndex.group)
+        {
+            return ListIndex(index.group + 1, index.item);
+        }
+        break;
+    case ModifyModeRemoveGroup:
+        if (index.group == modifyIndex.group)
+        {
+            return ListIndex(modifyIndex.group);
+        }
+        if (index.group > modifyIndex.group)
+        {
+            return ListIndex(index.group - 1, index.item);
+        }
+        break;
     }
+    return index;
 }
 
-std::list<ListViewPriv::LoadedItem>::iterator ListViewPriv::loadedItemAt(const ListIndex &index)
+bool ListViewPriv::isRemovedIndex(const ListIndex &index)
 {
-    auto it = std::lower_bound(loadedItems.begin(), loadedItems.end(), index, [](const LoadedItem& item, const ListIndex& idx)
+    const auto& modifyIndex = modifyInfo.index;
+    switch (modifyInfo.mode)
     {
-        return item.index < idx;
-    });
-    auto found = (it != loadedItems.end() && it->index == index);
-    return found ? it : loadedItems.end();
+    case ModifyModeRemoveItem:
+        return index.group == modifyIndex.group && index.item >= modifyIndex.item && index.item < modifyIndex.item + modifyInfo.count;
+    case ModifyModeRemoveGroup:
+        return index.group == modifyIndex.group;
+    default:
+        return false;
+    }
 }
 
-ListViewItemPriv *ListViewPriv::generateItemView(const ListIndex &index, int y, int height)
+ListViewItemPriv *ListViewPriv::generateItemView(const ListIndex &index, const QRect &rect)
 {
+    LISTVIEW_TRACE_SCOPE("generateItemView");
     ListViewItemPriv* result;
-    auto meta = currentDelegate->viewMetaObjectForIndex(index);
+    const QMetaObject* meta;
+    {
+        LISTVIEW_TRACE_SCOPE("delegate.viewMetaObjectForIndex");
+        meta = currentDelegate->viewMetaObjectForIndex(index);
+    }
     auto& list = reusePool[meta];
     if (list.empty())
     {
         auto item = dynamic_cast<ListViewItem*>(meta->newInstance(Q_ARG(QWidget*, scrollContent)));
         result = item->getPriv();
         result->listView = this;
+        LISTVIEW_STATS_INC(viewsCreated);
     }
     else
     {
         result = list.front();
         list.pop_front();
+        // 若仍在清理队列中，该项在空闲清理时会因为不在复用池中而被跳过
+        result->pooled = false;
+        LISTVIEW_STATS_INC(viewsReused);
+        if (result->bound)
+        {
+            // 空闲时还没来得及清理，先清理再展示新的数据项
+            cleanItemView(result);
+        }
     }
-    result->owner->setGeometry(0, y, owner->width(), height);
+    result->owner->setGeometry(rect);
     result->index = index;
     result->selected = OrderedListHelper::contains(selected, index);
+    result->depth = currentModel->owner->depthForIndex(index);
 
-    currentDelegate->prepareItemView(index, result->owner);
+    {
+        LISTVIEW_STATS_INC(prepareItemViewCalls);
+        LISTVIEW_STATS_TIME(prepareItemViewNs);
+        LISTVIEW_TRACE_SCOPE("delegate.prepareItemView");
+        currentDelegate->prepareItemView(index, result->owner);
+    }
+    result->bound = true;
 
     result->owner->show();
     return result;
 }
 
+void ListViewPriv::recycleLoadedItem(const LoadedItem &item)
+{
+    if (item.index.item == ListIndex::InvalidItemIndex)
+    {
+        if (auto& headerView = headerViews[item.index.group])
+        {
+            headerView->hide();
+        }
+    }
+    else
+    {
+        item.view->owner->hide();
+        reusePool[item.view->owner->metaObject()].push_back(item.view);
+        item.view->pooled = true;
+        if (item.view->bound && !item.view->queued)
+        {
+            item.view->queued = true;
+            cleanQueue.push_back(item.view);
+            scheduleClean();
+        }
+    }
+}
+
+void ListViewPriv::scheduleClean()
+{
+    if (!cleanTimer)
+    {
+        cleanTimer = new QTimer(owner);
+        cleanTimer->setSingleShot(true);
+        cleanTimer->callOnTimeout(owner, [=]{cleanPooledViews(ListViewCleanBudgetNs);});
+    }
+    if (!cleanTimer->isActive())
+    {
+        cleanTimer->start(0);
+    }
+}
+
+void ListViewPriv::cleanPooledViews(qint64 budgetNs)
+{
+    LISTVIEW_TRACE_SCOPE("cleanPooledViews");
+    QElapsedTimer timer;
+    timer.start();
+    // 队列中的视图可能已被重新取出并绑定到屏幕上的数据项，只清理仍在复用池中的视图
+    while (!cleanQueue.empty())
+    {
+        auto view = cleanQueue.front();
+        cleanQueue.pop_front();
+        view->queued = false;
+        if (view->pooled && view->bound)
+        {
+            cleanItemView(view);
+        }
+        if (budgetNs >= 0 && timer.nsecsElapsed() > budgetNs)
+        {
+            break;
+        }
+    }
+    if (!cleanQueue.empty())
+    {
+        scheduleClean();
+    }
+}
+
+void ListViewPriv::cleanItemView(ListViewItemPriv *view)
+{
+    LISTVIEW_STATS_INC(viewsCleaned);
+    LISTVIEW_TRACE_SCOPE("delegate.cleanItemView");
+    view->bound = false;
+    currentDelegate->cleanItemView(view->index, view->owner);
+}
+
+void ListViewPriv::collectFetchGroups(std::vector<int> &groups)
+{
+    auto model = currentModel->owner;
+    const auto limit = scrollArea->verticalScrollBar()->value() + 2 * scrollArea->height();
+    const auto nGroups = (int)heights->itemHeights.size();
+    for (auto group = loadedItems.empty() ? 0 : loadedItems.front().index.group; group < nGroups; group++)
+    {
+        const auto numItems = (int)heights->itemHeights[group].size();
+        const auto end = layout->itemRect(numItems ? ListIndex(group, numItems - 1) : ListIndex(group));
+        if (end.y() > limit)
+        {
+            // 之后的分组都在更下方
+            break;
+        }
+        if (!collapsedGroups[group] && !currentModel->fetchingGroups.count(group) && model->hasMoreItems(group))
+        {
+            groups.push_back(group);
+        }
+    }
+}
+
+void ListViewPriv::scheduleFetch()
+{
+    if (fetchTimer && fetchTimer->isActive())
+    {
+        return;
+    }
+    std::vector<int> groups;
+    collectFetchGroups(groups);
+    if (groups.empty())
+    {
+        return;
+    }
+    if (!fetchTimer)
+    {
+        fetchTimer = new QTimer(owner);
+        fetchTimer->setSingleShot(true);
+        fetchTimer->callOnTimeout(owner, [=]{fetchMoreItems();});
+    }
+    // 不在修改通知的过程中请求，子类可以在 fetchMoreItems 中同步地调用 itemsFetched
+    fetchTimer->start(0);
+}
+
+void ListViewPriv::fetchMoreItems()
+{
+    if (!currentModel || !currentDelegate || hasPendingChanges() || !modelNotEmpty())
+    {
+        return;
+    }
+    std::vector<int> groups;
+    collectFetchGroups(groups);
+    for (auto group : groups)
+    {
+        currentModel->requestMoreItems(group);
+    }
+}
+
+size_t ListViewPriv::reusePoolMemory() const
+{
+    size_t result = 0;
+    if (!currentDelegate)
+    {
+        return result;
+    }
+    for (auto& pair : reusePool)
+    {
+        for (auto view : pair.second)
+        {
+            result += currentDelegate->itemViewMemory(view->owner);
+        }
+    }
+    return result;
+}
+
+void ListViewPriv::prepareHeights(int group, int first, int count, int width)
+{
+    if (count > 1)
+    {
+        LISTVIEW_STATS_INC(prepareHeightsCalls);
+        LISTVIEW_STATS_TIME(prepareHeightsNs);
+        LISTVIEW_TRACE_SCOPE("delegate.prepareHeights");
+        currentDelegate->prepareHeights(group, first, count, width);
+    }
+}
+
+int ListViewPriv::measureHeight(const ListIndex &index, int width)
+{
+    LISTVIEW_STATS_INC(heightForIndexCalls);
+    LISTVIEW_STATS_TIME(heightForIndexNs);
+    LISTVIEW_TRACE_SCOPE("delegate.heightForIndex");
+    return currentDelegate->heightForIndex(index, width);
+}
+
 void ListViewPriv::processItemSelection(const ListIndex& index)
 {
     auto setItemSelected = [this](const ListIndex& itemIndex, bool selected)
@@ -1312,29 +2303,161 @@ int ListViewPriv::headerHeight(int group)
     return result;
 }
 
-int ListViewPriv::itemPosition(const ListIndex &index, const ListIndex& refIndex, int refY)
+QString ListViewPriv::verifyLayout()
 {
-    int result = 0;
-    int distance = 0;
-    auto pair = std::minmax(index, refIndex);
-    auto minIndex = pair.first;
-    auto maxIndex = pair.second;
-    while (minIndex != maxIndex)
+    applyJournal();
+    if (!currentModel || !currentDelegate)
     {
-        if (maxIndex.group > minIndex.group && minIndex.item == ListIndex::InvalidItemIndex)
+        return loadedItems.empty() ? QString() : QStringLiteral("items loaded without model or delegate");
+    }
+
+    auto model = currentModel->owner;
+    const auto nGroups = model->numGroups();
+    if ((int)heights->itemHeights.size() != nGroups || layout->groupCount() != nGroups || (int)headerViews.size() != nGroups)
+    {
+        return QString::asprintf("group count mismatch: model %d, itemHeights %d, layout %d, headerViews %d",
+                                 nGroups, (int)heights->itemHeights.size(), layout->groupCount(), (int)headerViews.size());
+    }
+
+    // 用相同的高度从头构建一份布局，与增量维护的布局对比
+    auto expected = createLayout(layoutMode);
+    for (int group = 0; group < nGroups; group++)
+    {
+        const auto& groupItemHeights = heights->itemHeights[group];
+        if ((int)groupItemHeights.size() != model->numItemsInGroup(group))
         {
-            distance += groupHeights[minIndex.group];
-            minIndex.group++;
+            delete expected;
+            return QString::asprintf("group %d item count mismatch: model %d, cached %d",
+                                     group, model->numItemsInGroup(group), (int)groupItemHeights.size());
         }
-        else
+        expected->insertGroup(group, headerHeight(group), groupItemHeights, collapsedGroups[group]);
+    }
+
+    auto result = compareLayout(*expected);
+    delete expected;
+    return result;
+}
+
+QString ListViewPriv::compareLayout(const ListLayoutEngine &expected)
+{
+    const auto nGroups = expected.groupCount();
+    for (int group = 0; group < nGroups; group++)
+    {
+        if (layout->groupTop(group) != expected.groupTop(group) || layout->groupHeight(group) != expected.groupHeight(group))
         {
-            auto currentHeight = minIndex.item == ListIndex::InvalidItemIndex
-                    ? headerHeight(minIndex.group)
-                    : itemHeights[minIndex.group][minIndex.item];
-            distance += currentHeight;
-            minIndex = increaseIndex(minIndex);
+            return QString::asprintf("group %d at y=%d h=%d, expected y=%d h=%d", group, layout->groupTop(group),
+                                     layout->groupHeight(group), expected.groupTop(group), expected.groupHeight(group));
         }
     }
-    result = index > refIndex ? refY + distance : refY - distance;
-    return result;
+    if (layout->contentHeight() != expected.contentHeight())
+    {
+        return QString::asprintf("contentHeight mismatch: expected %d, cached %d", expected.contentHeight(), layout->contentHeight());
+    }
+
+    if (!pendingItems.empty())
+    {
+        return QString::asprintf("%d pending items left after layout", (int)pendingItems.size());
+    }
+
+    // 已加载的数据项必须恰好是与视口相交的数据项
+    const auto viewportTop = scrollArea->verticalScrollBar()->value();
+    std::vector<ListIndex> visibleIndexes;
+    expected.indexesInRange(viewportTop, viewportTop + scrollArea->height(), visibleIndexes);
+    if (visibleIndexes.size() != loadedItems.size())
+    {
+        return QString::asprintf("%d items loaded, expected %d", (int)loadedItems.size(), (int)visibleIndexes.size());
+    }
+
+    auto visibleIt = visibleIndexes.begin();
+    for (auto& item : loadedItems)
+    {
+        const auto& index = *visibleIt++;
+        const auto rect = expected.itemRect(index);
+        if (item.index != index || item.rect != rect)
+        {
+            return QString::asprintf("loaded item (%d,%d) at (%d,%d %dx%d), expected (%d,%d) at (%d,%d %dx%d)",
+                                     item.index.group, item.index.item, item.rect.x(), item.rect.y(), item.rect.width(), item.rect.height(),
+                                     index.group, index.item, rect.x(), rect.y(), rect.width(), rect.height());
+        }
+        if (!item.index.isHeader())
+        {
+            if (item.view->index != item.index)
+            {
+                return QString::asprintf("view of (%d,%d) is bound to (%d,%d)", item.index.group, item.index.item,
+                                         item.view->index.group, item.view->index.item);
+            }
+            if (!item.view->bound)
+            {
+                return QString::asprintf("view of (%d,%d) was not prepared", item.index.group, item.index.item);
+            }
+            if (item.view->depth != currentModel->owner->depthForIndex(item.index))
+            {
+                return QString::asprintf("view of (%d,%d) has stale depth", item.index.group, item.index.item);
+            }
+            if (item.view->owner->geometry() != item.rect)
+            {
+                return QString::asprintf("view of (%d,%d) has stale geometry", item.index.group, item.index.item);
+            }
+            if (item.view->selected != OrderedListHelper::contains(selected, item.index))
+            {
+                return QString::asprintf("view of (%d,%d) has stale selected state", item.index.group, item.index.item);
+            }
+        }
+    }
+
+    // 查询接口与已加载项一致：可见范围落在已加载项之内，每个已加载项的中心点都映射回它自己
+    const auto range = visibleRange();
+    if (!range.isEmpty() && (loadedItems.empty() || range.first < loadedItems.front().index || range.last > loadedItems.back().index))
+    {
+        return QString::asprintf("visible range (%d,%d)-(%d,%d) is outside the loaded items",
+                                 range.first.group, range.first.item, range.last.group, range.last.item);
+    }
+    for (auto& item : loadedItems)
+    {
+        const auto rect = itemRect(item.index);
+        if (rect.isEmpty())
+        {
+            continue;
+        }
+        const auto hit = indexAt(QPoint(rect.x() + rect.width() / 2, rect.y() + rect.height() / 2));
+        if (hit != item.index)
+        {
+            return QString::asprintf("indexAt the center of (%d,%d) returned (%d,%d)", item.index.group, item.index.item, hit.group, hit.item);
+        }
+    }
+
+    for (auto it = selected.begin(); it != selected.end(); it++)
+    {
+        if (it->group < 0 || it->group >= nGroups || it->item < 0 || it->item >= (int)heights->itemHeights[it->group].size())
+        {
+            return QString::asprintf("selected index (%d,%d) is out of range", it->group, it->item);
+        }
+        auto next = std::next(it);
+        if (next != selected.end() && !(*it < *next))
+        {
+            return QString::asprintf("selection is not strictly ordered at (%d,%d)", it->group, it->item);
+        }
+    }
+
+    // 复用池中仍然绑定着数据项的视图都必须在清理队列中，且只出现一次
+    std::set<ListViewItemPriv*> queued;
+    for (auto view : cleanQueue)
+    {
+        if (!view->queued || !queued.insert(view).second)
+        {
+            return QString::asprintf("clean queue entry for (%d,%d) is duplicated or not flagged", view->index.group, view->index.item);
+        }
+    }
+    for (auto& pair : reusePool)
+    {
+        for (auto view : pair.second)
+        {
+            if (!view->pooled || (view->bound && !view->queued))
+            {
+                return QString::asprintf("pooled view of (%d,%d) will never be cleaned", view->index.group, view->index.item);
+            }
+        }
+    }
+    return QString();
 }
+
@@ -2,11 +2,63 @@
 #define LISTVIEW_H
 
 #include <set>
+#include <map>
 #include <QWidget>
 #include "listdatamodel.h"
 #include "listviewdelegate.h"
 #include "listviewitem.h"
 
+/**
+ * ListView 的运行时统计数据
+ * 仅当编译时定义了 LISTVIEW_STATS 才会被收集，否则 ListView::stats() 返回的所有数据均为 0。
+ * 耗时单位均为纳秒。
+ */
+struct ListViewStats
+{
+    /// 布局过程 (adjustLoadedItems) 执行的次数
+    quint64 layoutPasses = 0;
+    /// 新创建的数据项视图数量
+    quint64 viewsCreated = 0;
+    /// 从复用池中取出复用的数据项视图数量
+    quint64 viewsReused = 0;
+    /// 复用池中各视图类型的视图数量
+    std::map<const QMetaObject*, size_t> reusePoolSizes;
+    /// 复用池中视图占用的资源大小，见 ListView::reusePoolMemory
+    size_t reusePoolBytes = 0;
+    /// ListViewDelegate::cleanItemView 的调用次数
+    quint64 viewsCleaned = 0;
+
+    /// ListViewDelegate::heightForIndex 的调用次数与累计耗时
+    quint64 heightForIndexCalls = 0;
+    qint64 heightForIndexNs = 0;
+    /// ListViewDelegate::prepareHeights 的调用次数与累计耗时，只统计批量测量 (count > 1) 的调用
+    quint64 prepareHeightsCalls = 0;
+    qint64 prepareHeightsNs = 0;
+    /// ListViewDelegate::prepareItemView 的调用次数与累计耗时
+    quint64 prepareItemViewCalls = 0;
+    qint64 prepareItemViewNs = 0;
+
+    /// adjustLoadedItems 的累计、最近一次、最大耗时
+    qint64 adjustLoadedItemsNs = 0;
+    qint64 lastAdjustLoadedItemsNs = 0;
+    qint64 maxAdjustLoadedItemsNs = 0;
+    /// 单次 adjustLoadedItems 耗时超过帧预算的次数，按布局过程计数，同一帧内的多次布局分别计入
+    quint64 passesOverBudget = 0;
+};
+
+/**
+ * 视口中可见的分组头与数据项的范围，first 与 last 都包括在内
+ * 没有可见项时 first 与 last 都是空索引
+ */
+struct ListViewRange
+{
+    ListIndex first;
+    ListIndex last;
+    bool isEmpty() const {return first.isEmpty();}
+    bool operator==(const ListViewRange& other) const {return first == other.first && last == other.last;}
+    bool operator!=(const ListViewRange& other) const {return !(*this == other);}
+};
+
 /**
  * 😆 一个神奇的纵向列表视图类 😆
  *
@@ -24,9 +76,41 @@ class ListView : public QWidget
 {
     Q_OBJECT
 public:
+    /**
+     * 布局方式
+     */
+    enum LayoutMode
+    {
+        /// 纵向列表，每行一个数据项
+        ListLayout,
+        /// 网格，列数由 ListViewDelegate::preferredItemWidth 决定，分组头占满整行
+        GridLayout,
+        /// 瀑布流，列数与网格相同，数据项依次放入当前最短的一列
+        MasonryLayout
+    };
+
+    /**
+     * 内容变化时视口的锚定方式
+     */
+    enum AnchorMode
+    {
+        /// 以视口中第一个数据项的顶部为锚点（默认）
+        AnchorTop,
+        /// 以视口中最后一个数据项的底部为锚点，加载完成后显示在底部，适用于聊天记录：
+        /// 在上方插入历史消息或上方数据项高度变化时视口内容保持不动，
+        /// 仅当视口停留在底部时，新增内容后继续保持在底部
+        AnchorBottom
+    };
+
     ListView(QWidget* parent);
     ~ListView();
 
+    void setLayoutMode(LayoutMode mode);
+    LayoutMode layoutMode() const;
+
+    void setAnchorMode(AnchorMode mode);
+    AnchorMode anchorMode() const;
+
     void setDataModel(ListDataModel* model);
     void setViewDelegate(ListViewDelegate* delegate);
 
@@ -46,6 +130,89 @@ public:
     void scrollToTop();
     void scrollToBottom();
 
+    /**
+     * 视口中可见的范围，由布局的位置索引计算，复杂度为 O(log n) 加上可见项的数目
+     * 暂停且有尚未应用的修改时返回空范围
+     */
+    ListViewRange visibleRange() const;
+
+    /**
+     * 返回 ListView 坐标 pos 处的分组头或数据项，没有时返回空索引
+     */
+    ListIndex indexAt(const QPoint& pos) const;
+
+    /**
+     * 返回分组头或数据项在 ListView 坐标中的矩形（可以在视口之外），索引无效时返回空矩形
+     */
+    QRect itemRect(const ListIndex& index) const;
+
+    /**
+     * 折叠/展开分组，折叠的分组只显示分组头
+     * 只修改分组在布局位置索引中的高度（O(log n)），数据项的高度缓存与选中状态都保留，展开时不需要重新测量。
+     * 折叠状态随分组的插入删除调整，数据模型重新加载时全部展开。
+     */
+    void setGroupCollapsed(int group, bool collapsed);
+    bool isGroupCollapsed(int group) const;
+
+    /**
+     * 复用池中的视图仍然占用的资源大小（字节），即对其中每个视图调用 ListViewDelegate::itemViewMemory 的总和
+     * 回收的视图在空闲时才被清理，刚回收的视图仍然计入
+     */
+    size_t reusePoolMemory() const;
+
+    /**
+     * 立即清理复用池中所有尚未清理的视图，不必等待空闲时分批清理，例如在收到内存警告时调用
+     */
+    void releasePooledViews();
+
+    /**
+     * 返回运行时统计数据，需在编译时定义 LISTVIEW_STATS
+     */
+    ListViewStats stats() const;
+
+    /**
+     * 清零运行时统计数据
+     */
+    void resetStats();
+
+    /**
+     * 设置帧预算，adjustLoadedItems 耗时超过此值时计入 ListViewStats::passesOverBudget
+     * 默认为 16ms
+     */
+    void setFrameBudget(int us);
+
+    /**
+     * 设置 statsUpdated 信号的发送周期，单位毫秒，0 表示不发送（默认）。
+     * 未定义 LISTVIEW_STATS 时此函数无效果。
+     */
+    void setStatsInterval(int ms);
+
+    /**
+     * 暂停/恢复处理数据模型的修改
+     * 暂停期间数据模型的修改只被记录下来，不测量高度也不调整视图，恢复时一次性应用并只测量新增或更新的数据项；
+     * 修改过多或期间宽度改变时，恢复时改为重新加载。选中列表与 itemsInserted 等信号不受暂停影响。
+     * ListView 被隐藏（例如所在的标签页被切换走）时自动暂停，重新显示时自动恢复。
+     */
+    void setSuspended(bool suspended);
+    bool isSuspended() const;
+
+    /**
+     * 保留最近切换走的 count 个数据模型的布局状态（高度、布局、分组头、选中列表与滚动位置），默认为 0 即不保留
+     * 切换回这些数据模型时直接恢复，只需要测量期间新增或更新的数据项；
+     * 修改 delegate 或布局方式时清空，宽度改变后保存的状态不再使用。
+     */
+    void setModelCacheSize(int count);
+
+    /**
+     * 布局快照：保存数据项高度表与当前的滚动位置，用于下次启动时不再测量，直接回到上次的位置
+     * restoreLayoutSnapshot 可以在设置数据模型与 delegate 之前调用，快照在下一次加载时使用（已加载时立即重新加载）。
+     * 只有数据模型的 contentVersion 非 0 且与保存时相同、delegate 的 heightCacheKey 相同、
+     * 各分组的数据项数目相同（高度受宽度影响时还要求布局方式与宽度相同）时快照才会被使用，否则照常测量。
+     * 快照可以直接写入文件，下次启动时用 QFile::map 映射后以 QByteArray::fromRawData 传入，不需要复制。
+     */
+    QByteArray saveLayoutSnapshot();
+    void restoreLayoutSnapshot(const QByteArray& snapshot);
+
     class ListViewPriv *getPriv() const;
 
 signals:
@@ -56,9 +223,19 @@ signals:
     void groupRemoved(int group);
     void itemLeftClicked(const ListIndex& index, ListViewItem* item, QMouseEvent* e);
     void itemRightClicked(const ListIndex& index, ListViewItem* item, QMouseEvent* e);
+    void statsUpdated(const ListViewStats& stats);
+    void groupCollapsedChanged(int group, bool collapsed);
+
+    /**
+     * 可见范围改变，由滚动、尺寸变化或数据修改引起，每帧（约 16ms）最多发送一次
+     */
+    void visibleRangeChanged(const ListIndex& first, const ListIndex& last);
 
 protected:
     void resizeEvent(QResizeEvent*) override;
+    void showEvent(QShowEvent*) override;
+    void hideEvent(QHideEvent*) override;
+    void connectNotify(const QMetaMethod& signal) override;
 
 private:
     class ListViewPriv* priv;
@@ -66,6 +243,7 @@ private:
 
 
 Q_DECLARE_METATYPE(ListIndex)
+Q_DECLARE_METATYPE(ListViewStats)
 
 
 #endif
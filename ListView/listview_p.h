@@ -3,8 +3,14 @@
 
 #include "listview.h"
 #include "smoothscrollarea.h"
+#include "listviewstats_p.h"
+#include "listviewtrace_p.h"
+#include "listlayoutengine_p.h"
+#include "listheightstore_p.h"
+#include "listdatamodel_p.h"
 
 class ListViewItemPriv;
+class ListLayoutSnapshot;
 
 class ListViewPriv
 {
@@ -17,6 +23,10 @@ public:
     void processItemClick(QMouseEvent *event, const ListIndex& index, ListViewItemPriv* item);
     void setDataModel(ListDataModel* model);
     void setViewDelegate(ListViewDelegate* delegate);
+    void setLayoutMode(ListView::LayoutMode mode);
+    ListView::LayoutMode getLayoutMode() const;
+    void setAnchorMode(ListView::AnchorMode mode);
+    ListView::AnchorMode getAnchorMode() const;
 
     ListDataModel* dataModel() const;
     ListViewDelegate* viewDelegate() const;
@@ -27,8 +37,26 @@ public:
     void scrollToTop();
     void scrollToBottom();
 
+    /**
+     * 见 ListView::visibleRange / indexAt / itemRect
+     */
+    ListViewRange visibleRange();
+    ListIndex indexAt(const QPoint& pos);
+    QRect itemRect(const ListIndex& index);
+
+    void setGroupCollapsed(int group, bool collapsed);
+    bool isGroupCollapsed(int group) const;
+
+    /**
+     * visibleRangeChanged 信号被连接时调用，此后每次调整视图后最多每帧检查一次可见范围
+     */
+    void watchVisibleRange();
+
     void requireReload();
-    void itemUpdated(const ListIndex& index);
+    /**
+     * 分组中从 first 开始的 count 个数据项有更新，整个区间一次测量，只做一次布局
+     */
+    void itemsUpdated(const ListIndex& first, int count);
     void beginInsertItem(const ListIndex& insertIndex, size_t count);
     void endInsertItem();
     void beginInsertGroup(int groupIndex);
@@ -40,15 +68,69 @@ public:
 
     void onResized(const QSize &oldSize);
 
+    /**
+     * 开始/结束一批修改，可以嵌套
+     * 批内的修改只更新高度缓存、布局与已加载项的索引，结束时以开始时的锚点做一次布局与视图调整
+     */
+    void beginBatch();
+    void endBatch();
+
+    /**
+     * 暂停/恢复处理数据模型的修改，见 ListView::setSuspended
+     * 显式暂停或 ListView 被隐藏时都处于暂停状态，setHidden 由 showEvent / hideEvent 调用
+     */
+    void setSuspended(bool suspended);
+    bool isSuspended() const;
+    void setHidden(bool hidden);
+
+    void setModelCacheSize(int count);
+
+    /**
+     * 保存 / 恢复布局快照，见 ListView::saveLayoutSnapshot
+     */
+    QByteArray saveSnapshot();
+    void restoreSnapshot(const QByteArray& data);
+
+    /**
+     * 清理回收队列中的视图，budgetNs 为本轮的时间预算，超出后留到下一次空闲时，小于 0 表示全部清理
+     */
+    void cleanPooledViews(qint64 budgetNs);
+    size_t reusePoolMemory() const;
+
+    ListViewStats getStats() const;
+    void resetStats();
+    void setFrameBudget(int us);
+    void setStatsInterval(int ms);
+
+    /**
+     * 校验已缓存的高度、已加载视图的位置以及选中列表是否与数据模型一致
+     * 用于测试与调试，复杂度为 O(N)，不要在正常流程中调用
+     * @return 校验通过返回空字符串，否则返回第一处不一致的描述
+     */
+    QString verifyLayout();
+
 private:
     struct LoadedItem
     {
         ListIndex index;
-        int y;
-        int h;
+        QRect rect;
         ListViewItemPriv* view;
     };
 
+    /**
+     * 视口锚点，用于布局变化后保持视口内容不跳动
+     * index 为锚点数据项，distance 为其顶部到视口顶部的距离；
+     * fromBottom 为 true 时 distance 为视口底部到其底部的距离；
+     * bottom 为 true 时表示停留在底部。
+     */
+    struct ScrollAnchor
+    {
+        ListIndex index;
+        int distance = 0;
+        bool fromBottom = false;
+        bool bottom = false;
+    };
+
     SmoothScrollArea* scrollArea;
     QWidget* scrollContent;
 
@@ -56,6 +138,11 @@ private:
     ListViewDelegate* currentDelegate = nullptr;
 
     std::map<const QMetaObject*, std::list<ListViewItemPriv*>> reusePool;
+    // 已回收但尚未调用 cleanItemView 的视图，空闲时分批清理
+    std::deque<ListViewItemPriv*> cleanQueue;
+    QTimer* cleanTimer = nullptr;
+    // 分页加载：在下一次事件循环中请求已知末尾接近视口的分组的下一页
+    QTimer* fetchTimer = nullptr;
 
     std::list<LoadedItem> loadedItems;
 
@@ -64,10 +151,26 @@ private:
     std::list<ListIndex> selected;
 
     QWidget* emptyView = nullptr;
-    std::vector<QWidget*> headerViews;
-    std::vector<int> groupHeights;
-    std::vector<std::vector<int>> itemHeights;
-    int contentHeight = 0;
+    std::deque<QWidget*> headerViews;
+    // 各分组是否折叠，与 headerViews 一一对应；重新加载数据模型时全部展开
+    std::deque<bool> collapsedGroups;
+    // 数据项高度，关联数据模型与 delegate 后由数据模型分配，可能与其他视图共享；未关联时指向空的 localHeights
+    ListHeightStore localHeights;
+    ListHeightStore* heights = &localHeights;
+
+    ListView::LayoutMode layoutMode = ListView::ListLayout;
+    ListView::AnchorMode anchorMode = ListView::AnchorTop;
+    ListLayoutEngine* layout = nullptr;
+
+#ifdef LISTVIEW_STATS
+    ListViewStats stats;
+    qint64 frameBudgetNs = 16000000;
+    QTimer* statsTimer = nullptr;
+#endif
+
+    QTimer* visibleRangeTimer = nullptr;
+    // 最近一次通过 visibleRangeChanged 发出的范围
+    ListViewRange lastVisibleRange;
 
     enum ModifyMode
     {
@@ -75,7 +178,9 @@ private:
         ModifyModeInsertItem,
         ModifyModeRemoveItem,
         ModifyModeInsertGroup,
-        ModifyModeRemoveGroup
+        ModifyModeRemoveGroup,
+        // 只用于暂停期间的修改记录
+        ModifyModeUpdateItem
     };
 
     struct ModifyInfo
@@ -83,18 +188,116 @@ private:
         int mode = ModifyModeNone;
         ListIndex index;
         int count = 0;
+        // 修改前记录的锚点
+        ScrollAnchor anchor;
+        // 暂停期间的修改只被记录，end* 时不更新布局
+        bool deferred = false;
     }modifyInfo;
 
+    bool suspendRequested = false;
+    bool hidden = false;
+
+    struct JournalEntry
+    {
+        int mode;
+        ListIndex index;
+        int count;
+        // 修改发生时数据模型的修改序号，共享的高度缓存已应用的修改不再重放
+        quint64 serial;
+    };
+    std::vector<JournalEntry> journal;
+    // 暂停期间重新加载过、修改记录过多或宽度改变，恢复时重新加载
+    bool reloadOnResume = false;
+
+    /**
+     * 切换数据模型时保存的布局状态
+     * 保存期间作为数据模型的观察者记录修改，切换回来时与暂停期间的修改一样重放，
+     * 因此只需要测量新增或更新的数据项。
+     */
+    struct CachedState : public ListDataModelObserver
+    {
+        ListViewPriv* view;
+        ListDataModelPriv* model;
+        int width;
+        ScrollAnchor anchor;
+        ListHeightStore* heights;
+        ListLayoutEngine* layout;
+        std::deque<QWidget*> headerViews;
+        std::deque<bool> collapsedGroups;
+        std::list<ListIndex> selected;
+        std::vector<JournalEntry> journal;
+        // journal 中前 selectionShifted 条是保存之前暂停期间的修改，选中列表已经按它们调整过
+        size_t selectionShifted = 0;
+        bool reloadRequired = false;
+
+        void record(int mode, const ListIndex& index, int count);
+
+        void modelAboutToChange() override;
+        void modelReloaded() override;
+        void modelItemUpdated(const ListIndex& index) override;
+        void modelItemsUpdated(const ListIndex& first, int count) override;
+        void modelItemsInserted(const ListIndex& index, int count) override;
+        void modelItemsRemoved(const ListIndex& index, int count) override;
+        void modelGroupInserted(int group) override;
+        void modelGroupRemoved(int group) override;
+        void modelBatchBegin() override;
+        void modelBatchEnd() override;
+        void modelDestroyed() override;
+    };
+    // 最近切换走的数据模型的状态，最近的在前
+    std::list<CachedState*> modelCache;
+    int modelCacheSize = 0;
+
+    // 下一次加载时使用的布局快照
+    QByteArray pendingSnapshot;
+
+    int batchDepth = 0;
+    // 批量修改开始时记录的锚点，每次修改后换算为修改后的索引
+    ScrollAnchor batchAnchor;
+    // 批内是否有改变布局的修改，没有时结束批量修改不需要重新布局
+    bool batchChanged = false;
+
     void clear();
     void reload();
 
     void cacheHeaders();
-    int cacheHeightsAndAnchorPos(const ListIndex &anchorIndex = ListIndex());
+
+    /**
+     * 测量所有数据项的高度，高度缓存已是最新时直接使用，snapshot 不为空时从快照读取
+     */
+    void cacheHeights(const ListLayoutSnapshot* snapshot = nullptr);
+
+    /**
+     * 取出等待使用的快照，校验通过时返回 true
+     */
+    bool takeSnapshot(ListLayoutSnapshot& snapshot);
+
+    /**
+     * 按当前 delegate 与宽度向数据模型获取高度缓存 / 归还高度缓存
+     */
+    void attachHeights();
+    void detachHeights();
+
+    /**
+     * 当前修改是否需要由本视图更新高度缓存：共享的缓存只由第一个收到通知的视图更新
+     */
+    bool claimHeights();
+
+    /**
+     * 根据高度缓存与分组头高度重建布局
+     */
+    void rebuildLayout();
+    ListLayoutEngine* createLayout(ListView::LayoutMode mode);
 
     void setupEmptyView();
     void clearEmptyView();
 
+    /**
+     * 按视口范围向布局查询应显示的分组头和数据项，
+     * 复用已加载和 pendingItems 中的视图，回收其余视图。
+     */
     void adjustLoadedItems();
+    void adjustVisibleItems();
 
     /**
      * ListView 尺寸改变后，对已加载的视图做一些调整
@@ -102,26 +305,87 @@ private:
      */
     void fixContentSize(bool widthChanged);
 
-    void loadAboveItems();
-    void loadUnderItems();
-    void unloadOutOfViewportItems();
+    /**
+     * 布局改变之后调整内容高度，滚动视图使锚点保持在视口中原来的位置，然后重新加载视口内的数据项
+     */
+    void relayout(const ScrollAnchor& anchor);
+
+    /**
+     * 完成一次 begin* / end* 修改：不在批量修改中时调用 relayout ，
+     * 否则把 pendingItems 放回 loadedItems ，留到批量修改结束时统一调整
+     */
+    void finishModify();
+    void scrollToAnchor(const ScrollAnchor& anchor);
+    ScrollAnchor captureAnchor();
+
+    /**
+     * 修改数据模型时，把 modifyInfo.index 之后的已加载项按修改后的索引移入 pendingItems ，
+     * 回收被删除的数据项的视图
+     */
+    void shiftLoadedItems();
+    void shiftSelection();
+
+    bool hasPendingChanges() const;
+
+    /**
+     * 暂停时把 modifyInfo 描述的修改加入修改记录并返回 true ，否则返回 false
+     */
+    bool journalChange();
+
+    /**
+     * 应用暂停期间的修改：按记录调整高度缓存与分组头，只测量新增或更新的数据项，然后重建布局；
+     * 需要重新加载时重新加载
+     */
+    void applyJournal();
+    void replayJournal(ScrollAnchor anchor);
+
+    /**
+     * 切换数据模型前保存当前模型的状态 / 切换后恢复新模型已保存的状态
+     * 保存后 clear 不再回收被保存的高度缓存、布局与分组头；没有可用的状态时 restoreModelState 返回 false
+     */
+    void stashModelState();
+    bool restoreModelState();
+    void dropCachedState(CachedState* state);
+    void clearModelCache();
     void recyclePreloadedItems();
 
-    ListViewItemPriv* generateItemView(const ListIndex& index, int y, int height);
+    ListViewItemPriv* generateItemView(const ListIndex& index, const QRect& rect);
+    void recycleLoadedItem(const LoadedItem& item);
+    void scheduleClean();
+    void cleanItemView(ListViewItemPriv* view);
+
+    /**
+     * 已知的末尾在视口下方一屏以内、还有更多数据项并且没有正在请求的分组
+     */
+    void collectFetchGroups(std::vector<int>& groups);
+    void scheduleFetch();
+    void fetchMoreItems();
+
+    /**
+     * 即将测量分组中的一段数据项，通知 delegate 预先计算 (ListViewDelegate::prepareHeights)
+     */
+    void prepareHeights(int group, int first, int count, int width);
+
+    /**
+     * 向 delegate 请求数据项高度，所有对 heightForIndex 的调用都应经过此函数
+     */
+    int measureHeight(const ListIndex& index, int width);
 
     void processItemSelection(const ListIndex &index);
 
     // some helper functions
     bool modelNotEmpty();
     int headerHeight(int group);
-    int itemPosition(const ListIndex& index, const ListIndex &refIndex, int refY);
-    ListIndex increaseIndex(const ListIndex& index);
-    ListIndex decreaseIndex(const ListIndex& index);
-    void scrollWithoutNotify(int dy);
+    bool isValidIndex(const ListIndex& index);
 
-    void adjustItem(LoadedItem& item, const ListIndex &newIndex, int y);
+    /**
+     * 按照正在进行的修改 (modifyInfo) 计算修改前的索引在修改后对应的索引
+     * 被删除的索引映射到删除位置之后的第一个索引
+     */
+    ListIndex remapIndex(const ListIndex& index);
+    bool isRemovedIndex(const ListIndex& index);
 
-    std::list<LoadedItem>::iterator loadedItemAt(const ListIndex& index);
+    QString compareLayout(const ListLayoutEngine& expected);
 };
 
 #endif
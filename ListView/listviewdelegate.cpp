@@ -1,6 +1,11 @@
 #include "listviewdelegate.h"
 
 
+void ListViewDelegate::prepareHeights(int, int, int, int)
+{
+
+}
+
 void ListViewDelegate::prepareItemView(const ListIndex &, ListViewItem *)
 {
 
@@ -11,6 +16,11 @@ void ListViewDelegate::cleanItemView(const ListIndex &, ListViewItem *)
 
 }
 
+size_t ListViewDelegate::itemViewMemory(ListViewItem *)
+{
+    return 0;
+}
+
 bool ListViewDelegate::canSelectItem(const ListIndex &)
 {
     return false;
@@ -35,3 +45,13 @@ bool ListViewDelegate::canItemHeightAffectedByWidth()
 {
     return false;
 }
+
+QString ListViewDelegate::heightCacheKey()
+{
+    return QString();
+}
+
+int ListViewDelegate::preferredItemWidth(int )
+{
+    return 0;
+}
@@ -25,6 +25,15 @@ public:
      */
     virtual int heightForIndex(const ListIndex& index, int availableWidth) = 0;
 
+    /**
+     * ListView 即将对分组 group 中从 first 开始的 count 个数据项依次调用 heightForIndex 时调用此函数
+     * （加载、宽度改变、插入分组、批量插入或更新数据项时，count 大于 1 才会调用）
+     * 子类可以在此并行地预先计算这些高度，例如用 ListTextMeasurer::measureAll 在工作线程中排版文本，
+     * 之后的 heightForIndex 直接返回缓存的结果。
+     * 默认实现不做任何处理。
+     */
+    virtual void prepareHeights(int group, int first, int count, int availableWidth);
+
     /**
      * 请求数据项的视图类型元数据，视图类型必须从 ListItemView 继承
      * 用于在 ListView 中生成可复用的数据项视图
@@ -36,19 +45,28 @@ public:
     /**
      * 准备数据项视图
      * 在 ListView 即将展示对应的数据项时会调用此函数。
+     * 此时 view->depth() 已设置为数据项的缩进层级（树形模型中节点的层级，其他模型为 0）。
      * @param index 数据项索引
      * @param view 数据项视图
      */
     virtual void prepareItemView(const ListIndex& index, ListViewItem* view);
 
     /**
-     * 清理数据项视图
-     * 在 ListView 即将回收对应的数据项时会调用此函数。
-     * @param index 数据项索引
-     * @param view 数据项视图，函数调用完成后此视图会被收回 ListView 的复用池。
+     * 清理数据项视图，应在此释放 prepareItemView 绑定到视图上的图片、模型等资源
+     * 数据项视图被回收进复用池之后，ListView 在空闲时分批调用此函数；视图在清理之前被再次取出时，先清理再调用 prepareItemView 。
+     * 每次 prepareItemView 之后都会有且只有一次对应的 cleanItemView ，ListView 被删除时尚未清理的视图除外。
+     * 由于调用可能推迟，删除 delegate 之前应先删除 ListView 或调用 setViewDelegate 更换 delegate（更换时会立即清理）。
+     * @param index 视图最后展示的数据项索引，此时该数据项可能已被删除
+     * @param view 数据项视图，此时已在复用池中
      */
     virtual void cleanItemView(const ListIndex& index, ListViewItem* view);
 
+    /**
+     * 返回数据项视图当前占用的资源大小（字节），用于 ListView::reusePoolMemory 统计复用池中视图占用的内存
+     * 默认实现返回 0
+     */
+    virtual size_t itemViewMemory(ListViewItem* view);
+
     /**
      * 如果 index 指定的数据项可以被选中，请返回 true ，否则返回 false
      */
@@ -83,6 +101,22 @@ public:
      */
     virtual bool canItemHeightAffectedByWidth();
 
+    /**
+     * 高度缓存的共享标识
+     * 同一个 DataModel 被多个 ListView 展示时，标识相同的 delegate 在相同的宽度下（高度不受宽度影响时不限宽度）
+     * 共享数据项高度的缓存，每次修改数据只测量一次。只有 heightForIndex 结果完全相同的 delegate 才能返回相同的标识。
+     * 默认实现返回空字符串，即不共享。
+     */
+    virtual QString heightCacheKey();
+
+    /**
+     * 网格布局 (ListView::GridLayout) 与瀑布流布局 (ListView::MasonryLayout) 下分组中数据项的期望宽度
+     * ListView 以 可用宽度 / 期望宽度 作为该分组的列数（至少 1 列），各列平分可用宽度，
+     * 此时 heightForIndex 的 availableWidth 参数为单元格宽度。
+     * 默认实现返回 0 ，即每行只有一个数据项。
+     */
+    virtual int preferredItemWidth(int group);
+
 };
 
 #endif
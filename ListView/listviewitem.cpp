@@ -34,6 +34,11 @@ bool ListViewItem::isLastItem() const
     return priv->isLastItem;
 }
 
+int ListViewItem::depth() const
+{
+    return priv->depth;
+}
+
 void ListViewItem::setHover(bool hover)
 {
     if (priv->hover == hover)
@@ -20,6 +20,11 @@ public:
     bool selected() const;
     bool isLastItem() const;
 
+    /**
+     * 数据项的缩进层级 (ListDataModel::depthForIndex) ，在 prepareItemView 之前设置
+     */
+    int depth() const;
+
     class ListViewItemPriv *getPriv() const;
 
 public slots:
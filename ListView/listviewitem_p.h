@@ -20,6 +20,13 @@ public:
     bool selected = false;
     QPoint pressPos;
     bool isLastItem = false;
+    int depth = 0;
+    // 已调用 prepareItemView ，尚未调用 cleanItemView
+    bool bound = false;
+    // 在复用池中
+    bool pooled = false;
+    // 在 ListViewPriv::cleanQueue 中，每个视图在队列中最多出现一次
+    bool queued = false;
 };
 
 
@@ -0,0 +1,77 @@
+#ifndef LISTVIEWSTATS_P_H
+#define LISTVIEWSTATS_P_H
+
+#include "listview.h"
+
+/**
+ * ListView 运行时统计的埋点工具
+ * 仅在定义了 LISTVIEW_STATS 时生效，否则所有宏展开为空语句，不产生任何开销。
+ */
+#ifdef LISTVIEW_STATS
+
+#include <QElapsedTimer>
+
+/**
+ * 作用域计时器，析构时将耗时累加到指定的计数器上
+ */
+class ListViewStatsScopedTimer
+{
+public:
+    explicit ListViewStatsScopedTimer(qint64& totalNs) : totalNs(totalNs)
+    {
+        timer.start();
+    }
+    ~ListViewStatsScopedTimer()
+    {
+        totalNs += timer.nsecsElapsed();
+    }
+
+private:
+    qint64& totalNs;
+    QElapsedTimer timer;
+};
+
+/**
+ * 布局过程 (adjustLoadedItems) 的计时器，析构时更新次数、最近/最大耗时与单次超出帧预算的次数
+ */
+class ListViewStatsPassTimer
+{
+public:
+    ListViewStatsPassTimer(ListViewStats& stats, qint64 frameBudgetNs) : stats(stats), frameBudgetNs(frameBudgetNs)
+    {
+        timer.start();
+    }
+    ~ListViewStatsPassTimer()
+    {
+        auto elapsed = timer.nsecsElapsed();
+        stats.layoutPasses++;
+        stats.adjustLoadedItemsNs += elapsed;
+        stats.lastAdjustLoadedItemsNs = elapsed;
+        stats.maxAdjustLoadedItemsNs = qMax(stats.maxAdjustLoadedItemsNs, elapsed);
+        if (elapsed > frameBudgetNs)
+        {
+            stats.passesOverBudget++;
+        }
+    }
+
+private:
+    ListViewStats& stats;
+    qint64 frameBudgetNs;
+    QElapsedTimer timer;
+};
+
+#define LISTVIEW_STATS_CONCAT_(a, b) a##b
+#define LISTVIEW_STATS_CONCAT(a, b) LISTVIEW_STATS_CONCAT_(a, b)
+#define LISTVIEW_STATS_INC(field) (stats.field++)
+#define LISTVIEW_STATS_TIME(field) ListViewStatsScopedTimer LISTVIEW_STATS_CONCAT(statsTimer_, __LINE__)(stats.field)
+#define LISTVIEW_STATS_PASS() ListViewStatsPassTimer LISTVIEW_STATS_CONCAT(statsPassTimer_, __LINE__)(stats, frameBudgetNs)
+
+#else
+
+#define LISTVIEW_STATS_INC(field) do {} while (0)
+#define LISTVIEW_STATS_TIME(field) do {} while (0)
+#define LISTVIEW_STATS_PASS() do {} while (0)
+
+#endif
+
+#endif // LISTVIEWSTATS_P_H
@@ -0,0 +1,289 @@
+#include "listviewtrace_p.h"
+#include <QFile>
+
+#ifdef LISTVIEW_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char* name;
+    qint64 startNs;
+    qint64 durationNs;
+};
+
+const size_t TraceChunkSize = 4096;
+
+struct TraceChunk
+{
+    TraceEvent events[TraceChunkSize];
+    std::atomic<TraceChunk*> next{nullptr};
+};
+
+/**
+ * 单个线程的事件缓冲区
+ * 只有所属线程会写入；写入完成后以 release 语义更新 count ，导出线程以 acquire 语义读取 count ，
+ * 因此导出时不需要加锁，也不会读到写了一半的事件。
+ * 缓冲区由块链表组成，块一旦分配便不会释放，直到进程退出。
+ * clear() 只设置 resetPending ，由所属线程在下次写入前清空计数，避免与正在进行的写入竞争；
+ * 清空之前导出线程把 resetPending 仍为 true 的缓冲区视为空。
+ */
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(int tid) : tid(tid), head(new TraceChunk), tail(head) {}
+    ~ThreadBuffer()
+    {
+        auto chunk = head;
+        while (chunk)
+        {
+            auto next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    void append(const TraceEvent& event, size_t maxEvents)
+    {
+        // acquire 保证覆盖旧事件发生在清空之前的导出读取之后
+        if (resetPending.load(std::memory_order_acquire))
+        {
+            // 先清空计数再清除标记，导出线程读到标记为 false 时一定能读到清空后的计数
+            count.store(0, std::memory_order_relaxed);
+            dropped.store(0, std::memory_order_relaxed);
+            resetPending.store(false, std::memory_order_release);
+        }
+        auto index = count.load(std::memory_order_relaxed);
+        if (index >= maxEvents)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto offset = index % TraceChunkSize;
+        if (index == 0)
+        {
+            tail = head;
+        }
+        else if (offset == 0)
+        {
+            auto next = tail->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                next = new TraceChunk;
+                tail->next.store(next, std::memory_order_release);
+            }
+            tail = next;
+        }
+        tail->events[offset] = event;
+        count.store(index + 1, std::memory_order_release);
+    }
+
+    const int tid;
+    TraceChunk* const head;
+    // 仅由写入线程访问
+    TraceChunk* tail;
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> resetPending{false};
+
+    /**
+     * 导出线程读取已提交的事件数量，清空请求尚未处理时为 0
+     */
+    size_t committed() const
+    {
+        return resetPending.load(std::memory_order_acquire) ? 0 : count.load(std::memory_order_acquire);
+    }
+};
+
+struct TraceRegistry
+{
+    std::atomic<bool> enabled{false};
+    std::atomic<size_t> maxEventsPerThread{0};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    // 仅在线程首次记录事件以及导出时加锁
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    ThreadBuffer* registerThread()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.emplace_back(new ThreadBuffer((int)buffers.size() + 1));
+        return buffers.back().get();
+    }
+};
+
+TraceRegistry& registry()
+{
+    static TraceRegistry instance;
+    return instance;
+}
+
+thread_local ThreadBuffer* localBuffer = nullptr;
+
+void appendJsonString(QByteArray& out, const char* text)
+{
+    out.append('"');
+    for (auto p = text; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            out.append('\\');
+        }
+        out.append(*p);
+    }
+    out.append('"');
+}
+
+}
+
+bool ListViewTracePriv::enabled()
+{
+    return registry().enabled.load(std::memory_order_relaxed);
+}
+
+qint64 ListViewTracePriv::now()
+{
+    auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void ListViewTracePriv::record(const char *name, qint64 startNs, qint64 durationNs)
+{
+    auto& reg = registry();
+    if (!localBuffer)
+    {
+        localBuffer = reg.registerThread();
+    }
+    localBuffer->append({name, startNs, durationNs}, reg.maxEventsPerThread.load(std::memory_order_relaxed));
+}
+
+bool ListViewTrace::start(size_t maxEventsPerThread)
+{
+    auto& reg = registry();
+    reg.maxEventsPerThread.store(maxEventsPerThread, std::memory_order_relaxed);
+    reg.enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void ListViewTrace::stop()
+{
+    registry().enabled.store(false, std::memory_order_relaxed);
+}
+
+bool ListViewTrace::isEnabled()
+{
+    return ListViewTracePriv::enabled();
+}
+
+void ListViewTrace::clear()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& buffer : reg.buffers)
+    {
+        buffer->resetPending.store(true, std::memory_order_release);
+    }
+}
+
+size_t ListViewTrace::droppedEvents()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t result = 0;
+    for (auto& buffer : reg.buffers)
+    {
+        if (!buffer->resetPending.load(std::memory_order_relaxed))
+        {
+            result += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+QByteArray ListViewTrace::toJson()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    QByteArray out;
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    char buffer[160];
+    for (auto& threadBuffer : reg.buffers)
+    {
+        snprintf(buffer, sizeof(buffer),
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"ListView thread %d\"}}",
+                 first ? "" : ",", threadBuffer->tid, threadBuffer->tid);
+        out.append(buffer);
+        first = false;
+
+        const auto count = threadBuffer->committed();
+        auto chunk = threadBuffer->head;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i && i % TraceChunkSize == 0)
+            {
+                chunk = chunk->next.load(std::memory_order_acquire);
+            }
+            const auto& event = chunk->events[i % TraceChunkSize];
+            out.append(",{\"name\":");
+            appendJsonString(out, event.name);
+            // trace event 的时间单位为微秒
+            snprintf(buffer, sizeof(buffer), ",\"cat\":\"ListView\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                     event.startNs / 1000.0, event.durationNs / 1000.0, threadBuffer->tid);
+            out.append(buffer);
+        }
+    }
+    out.append("]}\n");
+    return out;
+}
+
+#else
+
+bool ListViewTrace::start(size_t)
+{
+    return false;
+}
+
+void ListViewTrace::stop()
+{
+}
+
+bool ListViewTrace::isEnabled()
+{
+    return false;
+}
+
+void ListViewTrace::clear()
+{
+}
+
+size_t ListViewTrace::droppedEvents()
+{
+    return 0;
+}
+
+QByteArray ListViewTrace::toJson()
+{
+    return QByteArray("{\"traceEvents\":[]}\n");
+}
+
+#endif
+
+bool ListViewTrace::writeTo(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    auto json = toJson();
+    return file.write(json) == json.size();
+}
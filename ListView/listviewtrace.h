@@ -0,0 +1,60 @@
+#ifndef LISTVIEWTRACE_H
+#define LISTVIEWTRACE_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * ListView 性能追踪
+ * 记录 reload、布局、视图生成、delegate 回调、平滑滚动等过程的耗时区间，
+ * 并导出为 Chrome / Perfetto 可以直接打开的 trace event JSON 文件 (chrome://tracing, ui.perfetto.dev)。
+ *
+ * 需要在编译时定义 LISTVIEW_TRACE 才会埋点，否则 start() 返回 false 且没有任何运行时开销。
+ * 每个线程写入自己的缓冲区，写入过程无锁；导出时只读取已提交的事件。
+ *
+ * 用法：
+ *     ListViewTrace::start();
+ *     ... 复现卡顿 ...
+ *     ListViewTrace::stop();
+ *     ListViewTrace::writeTo("listview-trace.json");
+ */
+class ListViewTrace
+{
+public:
+    /**
+     * 开始记录
+     * @param maxEventsPerThread 每个线程最多记录的事件数量，超出的事件会被丢弃
+     * @return 未定义 LISTVIEW_TRACE 时返回 false
+     */
+    static bool start(size_t maxEventsPerThread = 1 << 20);
+
+    /**
+     * 停止记录，已记录的事件会被保留直到调用 clear()
+     */
+    static void stop();
+
+    static bool isEnabled();
+
+    /**
+     * 丢弃所有已记录的事件
+     * 可以在记录过程中调用，各线程在下次写入事件时清空自己的缓冲区，之后的导出不再包含之前的事件
+     */
+    static void clear();
+
+    /**
+     * 因超出缓冲区上限而被丢弃的事件数量
+     */
+    static size_t droppedEvents();
+
+    /**
+     * 导出 Chrome trace event 格式的 JSON
+     */
+    static QByteArray toJson();
+
+    /**
+     * 将 toJson() 的结果写入文件
+     */
+    static bool writeTo(const QString& path);
+};
+
+#endif // LISTVIEWTRACE_H
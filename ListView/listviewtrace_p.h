@@ -0,0 +1,50 @@
+#ifndef LISTVIEWTRACE_P_H
+#define LISTVIEWTRACE_P_H
+
+#include "listviewtrace.h"
+
+/**
+ * 追踪埋点
+ * LISTVIEW_TRACE_SCOPE("name") 记录从当前位置到作用域结束的耗时区间，name 必须是字符串字面量。
+ * 未定义 LISTVIEW_TRACE 时展开为空语句。
+ */
+#ifdef LISTVIEW_TRACE
+
+namespace ListViewTracePriv
+{
+extern bool enabled();
+extern qint64 now();
+extern void record(const char* name, qint64 startNs, qint64 durationNs);
+}
+
+class ListViewTraceScope
+{
+public:
+    explicit ListViewTraceScope(const char* name)
+        : name(name), startNs(ListViewTracePriv::enabled() ? ListViewTracePriv::now() : -1)
+    {
+    }
+    ~ListViewTraceScope()
+    {
+        if (startNs >= 0)
+        {
+            ListViewTracePriv::record(name, startNs, ListViewTracePriv::now() - startNs);
+        }
+    }
+
+private:
+    const char* name;
+    qint64 startNs;
+};
+
+#define LISTVIEW_TRACE_CONCAT_(a, b) a##b
+#define LISTVIEW_TRACE_CONCAT(a, b) LISTVIEW_TRACE_CONCAT_(a, b)
+#define LISTVIEW_TRACE_SCOPE(name) ListViewTraceScope LISTVIEW_TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#else
+
+#define LISTVIEW_TRACE_SCOPE(name) do {} while (0)
+
+#endif
+
+#endif // LISTVIEWTRACE_P_H
@@ -1,4 +1,5 @@
 #include "smoothscrollarea.h"
+#include "listviewtrace_p.h"
 #include <QWheelEvent>
 
 static const double DefaultWheelSpeedMs = 1.0;
@@ -57,6 +58,7 @@ void SmoothScrollArea::superWheelEvent(QWheelEvent *event)
 
 void SmoothScrollArea::smoothWheelTimeout()
 {
+    LISTVIEW_TRACE_SCOPE("smoothScroll.tick");
     auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - _lastAnimationTime).count();
     _lastAnimationTime = now;
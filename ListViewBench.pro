@@ -0,0 +1,24 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += LISTVIEW_STATS LISTVIEW_TRACE
+
+# 基准测试需要在 offscreen 平台下运行，main 中会在未指定 QT_QPA_PLATFORM 时自动设置。
+# 用法： ListViewBench [--rows 1000,10000,...] [--dists uniform,random,bimodal] [--output result.jsonl] [--label v1.2] [--trace trace.json]
+# 校验： ListViewBench --verify 5000 [--headers] [--layout list|grid|masonry] [--anchor top|bottom]  随机修改数据并校验布局不变式与代价上界，失败时返回非 0
+
+SOURCES += \
+    ListViewBench/main.cpp \
+    ListViewBench/verifier.cpp
+
+HEADERS += \
+    ListViewBench/benchmodel.h \
+    ListViewBench/verifier.h
+
+include(ListView.pri)
+
+win32-msvc: QMAKE_CXXFLAGS += /utf-8
@@ -0,0 +1,474 @@
+#ifndef BENCHMODEL_H
+#define BENCHMODEL_H
+
+#include "ListView/listview.h"
+#include "ListView/listviewitem.h"
+#include "ListView/listtreemodel.h"
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// --layout grid|masonry 时数据项的期望宽度
+static const int BenchGridItemWidth = 120;
+
+/**
+ * 基准测试用的合成数据模型，同时实现了 ListViewDelegate
+ * 数据项高度按分布生成并保存在模型中，heightForIndex 直接查表，尽量不干扰 ListView 本身的耗时。
+ */
+class BenchModel : public ListDataModel, public ListViewDelegate
+{
+public:
+    enum Distribution
+    {
+        Uniform,
+        Random,
+        Bimodal
+    };
+
+    static bool parseDistribution(const std::string& name, Distribution& dist)
+    {
+        if (name == "uniform")
+            dist = Uniform;
+        else if (name == "random")
+            dist = Random;
+        else if (name == "bimodal")
+            dist = Bimodal;
+        else
+            return false;
+        return true;
+    }
+
+    static const char* distributionName(Distribution dist)
+    {
+        switch (dist)
+        {
+        case Uniform: return "uniform";
+        case Random: return "random";
+        case Bimodal: return "bimodal";
+        }
+        return "unknown";
+    }
+
+    BenchModel(Distribution dist, size_t rows, int groupSize, bool withHeaders, unsigned seed = 20200501)
+        : dist(dist), withHeaders(withHeaders), rng(seed)
+    {
+        size_t left = rows;
+        while (left)
+        {
+            auto n = std::min<size_t>(left, groupSize);
+            heights.emplace_back(n);
+            for (auto& h : heights.back())
+            {
+                h = nextHeight();
+            }
+            left -= n;
+        }
+    }
+
+    int nextHeight()
+    {
+        switch (dist)
+        {
+        case Uniform:
+            return 48;
+        case Random:
+            return 24 + int(rng() % 97);
+        case Bimodal:
+            // 大部分是单行文本，少量是带图片的大卡片
+            return (rng() % 10) ? 40 + int(rng() % 5) : 200 + int(rng() % 41);
+        }
+        return 48;
+    }
+
+    int minHeight() const
+    {
+        switch (dist)
+        {
+        case Uniform: return 48;
+        case Random: return 24;
+        case Bimodal: return 40;
+        }
+        return 1;
+    }
+
+    std::mt19937& random()
+    {
+        return rng;
+    }
+
+    int height(const ListIndex& index) const
+    {
+        return heights[index.group][index.item];
+    }
+
+    size_t totalRows() const
+    {
+        size_t result = 0;
+        for (auto& group : heights)
+        {
+            result += group.size();
+        }
+        return result;
+    }
+
+    ListIndex randomIndex()
+    {
+        if (totalRows() == 0)
+        {
+            return ListIndex();
+        }
+        int group = int(rng() % heights.size());
+        while (heights[group].empty())
+        {
+            group = int(rng() % heights.size());
+        }
+        return ListIndex(group, int(rng() % heights[group].size()));
+    }
+
+    /**
+     * 网格与瀑布流布局下的期望宽度，0 表示每行一个数据项
+     */
+    void setPreferredItemWidth(int width)
+    {
+        preferredWidth = width;
+    }
+
+    /**
+     * 是否允许同一模型上的视图共享高度缓存，默认允许
+     */
+    void setShareHeights(bool share)
+    {
+        shareHeights = share;
+    }
+
+    void reset()
+    {
+        requireReload();
+    }
+
+    void setHeight(const ListIndex& index, int height)
+    {
+        version++;
+        heights[index.group][index.item] = height;
+        itemUpdated(index);
+    }
+
+    /**
+     * 重新生成从 first 开始的 count 个数据项的高度，模拟主题切换后整段刷新
+     */
+    void refreshItems(const ListIndex& first, int count)
+    {
+        version++;
+        auto& groupHeights = heights[first.group];
+        for (int item = first.item; item < first.item + count; item++)
+        {
+            groupHeights[item] = nextHeight();
+        }
+        itemsUpdated(first, count);
+    }
+
+    void insertItems(const ListIndex& index, int count)
+    {
+        version++;
+        auto& groupHeights = heights[index.group];
+        beginInsertItems(index, count);
+        std::vector<int> inserted(count);
+        for (auto& h : inserted)
+        {
+            h = nextHeight();
+        }
+        groupHeights.insert(groupHeights.begin() + index.item, inserted.begin(), inserted.end());
+        endInsertItems();
+    }
+
+    void removeItems(const ListIndex& index, int count)
+    {
+        version++;
+        auto& groupHeights = heights[index.group];
+        beginRemoveItems(index, count);
+        groupHeights.erase(groupHeights.begin() + index.item, groupHeights.begin() + index.item + count);
+        endRemoveItems();
+    }
+
+    void insertGroup(int group, int count)
+    {
+        version++;
+        std::deque<int> inserted(count);
+        for (auto& h : inserted)
+        {
+            h = nextHeight();
+        }
+        beginInsertGroup(group);
+        heights.insert(heights.begin() + group, std::move(inserted));
+        endInsertGroup();
+    }
+
+    void removeGroup(int group)
+    {
+        version++;
+        beginRemoveGroup(group);
+        heights.erase(heights.begin() + group);
+        endRemoveGroup();
+    }
+
+    /**
+     * 模拟日志流：在末尾追加 count 个数据项，每 groupSize 项开始一个新分组
+     */
+    void streamItems(int count, int groupSize)
+    {
+        version++;
+        while (count > 0)
+        {
+            if (heights.empty() || (int)heights.back().size() >= groupSize)
+            {
+                heights.emplace_back();
+                appendGroup();
+            }
+            auto n = std::min(count, groupSize - (int)heights.back().size());
+            for (int i = 0; i < n; i++)
+            {
+                heights.back().push_back(nextHeight());
+            }
+            appendItems(n);
+            count -= n;
+        }
+    }
+
+    void setRetention(int maxItems)
+    {
+        setRetentionLimit(maxItems);
+    }
+
+    void setCoalescing(bool enabled)
+    {
+        setUpdateCoalescing(enabled);
+    }
+
+    /**
+     * 数据项内容改变但高度不变，例如行情列表中的价格刷新
+     */
+    void touch(const ListIndex& index)
+    {
+        itemUpdated(index);
+    }
+
+    void flush()
+    {
+        flushAppends();
+    }
+
+    /**
+     * 跨线程修改：可在任意线程调用，数据在 UI 线程执行这条修改时才写入模型
+     * onApply 在写入时于 UI 线程调用，校验模式用它按实际的执行顺序维护期望值
+     */
+    void postInsert(const ListIndex& index, const std::vector<int>& inserted, std::function<void()> onApply)
+    {
+        postInsertItems(index, inserted.size(), [this, index, inserted, onApply]{
+            version++;
+            auto& groupHeights = heights[index.group];
+            groupHeights.insert(groupHeights.begin() + index.item, inserted.begin(), inserted.end());
+            onApply();
+        });
+    }
+
+    void postRemove(const ListIndex& index, int count, std::function<void()> onApply)
+    {
+        postRemoveItems(index, count, [this, index, count, onApply]{
+            version++;
+            auto& groupHeights = heights[index.group];
+            groupHeights.erase(groupHeights.begin() + index.item, groupHeights.begin() + index.item + count);
+            onApply();
+        });
+    }
+
+    void postUpdate(const ListIndex& index, int height, std::function<void()> onApply)
+    {
+        postItemUpdated(index, [this, index, height, onApply]{
+            version++;
+            heights[index.group][index.item] = height;
+            onApply();
+        });
+    }
+
+    void postAppend(const std::vector<int>& appended, std::function<void()> onApply)
+    {
+        postAppendItems(appended.size(), [this, appended, onApply]{
+            version++;
+            heights.back().insert(heights.back().end(), appended.begin(), appended.end());
+            onApply();
+        });
+    }
+
+    // ListDataModel interface
+public:
+    quint64 contentVersion() override
+    {
+        return version;
+    }
+    int numGroups() override
+    {
+        return (int)heights.size();
+    }
+    int numItemsInGroup(int group) override
+    {
+        return (int)heights[group].size();
+    }
+protected:
+    void dropLeadingGroup() override
+    {
+        heights.pop_front();
+    }
+    void dropLeadingItems(int count) override
+    {
+        heights.front().erase(heights.front().begin(), heights.front().begin() + count);
+    }
+
+    // ListViewDelegate interface
+public:
+    int heightForIndex(const ListIndex& index, int) override
+    {
+        return heights[index.group][index.item];
+    }
+    const QMetaObject* viewMetaObjectForIndex(const ListIndex&) override
+    {
+        return &ListViewItem::staticMetaObject;
+    }
+    bool canSelectItem(const ListIndex&) override
+    {
+        return true;
+    }
+    bool isMultipleSelection() override
+    {
+        return true;
+    }
+    bool canItemHeightAffectedByWidth() override
+    {
+        return true;
+    }
+    QString heightCacheKey() override
+    {
+        return shareHeights ? QStringLiteral("bench") : QString();
+    }
+    int preferredItemWidth(int) override
+    {
+        return preferredWidth;
+    }
+    QWidget* headerViewForGroup(int) override
+    {
+        if (!withHeaders)
+        {
+            return nullptr;
+        }
+        auto w = new QWidget();
+        w->resize(200, 32);
+        return w;
+    }
+
+private:
+    Distribution dist;
+    bool withHeaders;
+    int preferredWidth = 0;
+    bool shareHeights = true;
+    // 每次修改数据后递增，用于校验布局快照
+    quint64 version = 1;
+    std::mt19937 rng;
+    std::deque<std::deque<int>> heights;
+};
+
+/**
+ * 基准测试用的树形数据模型：第一层 roots 个节点，第二层每个节点有 fanout 个子节点，第三层每个节点有 10 个子节点
+ * 数据项高度固定，测量只反映展开、折叠与索引换算本身的耗时
+ */
+class BenchTreeModel : public ListTreeModel, public ListViewDelegate
+{
+public:
+    BenchTreeModel(int roots, int fanout) : roots(roots), fanout(fanout) {}
+
+    int numRoots() const
+    {
+        return roots;
+    }
+
+    // ListTreeModel interface
+public:
+    int numChildren(const ListTreePath& parent) override
+    {
+        switch (parent.size())
+        {
+        case 0: return roots;
+        case 1: return fanout;
+        case 2: return 10;
+        }
+        return 0;
+    }
+
+    // ListViewDelegate interface
+public:
+    int heightForIndex(const ListIndex& index, int) override
+    {
+        return index.isHeader() ? 0 : 32;
+    }
+    const QMetaObject* viewMetaObjectForIndex(const ListIndex&) override
+    {
+        return &ListViewItem::staticMetaObject;
+    }
+
+private:
+    int roots;
+    int fanout;
+};
+
+/**
+ * 基准测试用的分页数据模型：一个分组，共 total 个数据项，但视图只能看到已取得的部分，每次请求取得 pageSize 个
+ * 请求时同步返回下一页，模拟服务端数据已经在本地缓存中的情况
+ */
+class BenchPagedModel : public ListDataModel, public ListViewDelegate
+{
+public:
+    BenchPagedModel(size_t total, int pageSize)
+        : total(total), pageSize(pageSize), fetched(std::min<size_t>(total, pageSize))
+    {
+    }
+
+    // ListDataModel interface
+public:
+    int numGroups() override
+    {
+        return 1;
+    }
+    int numItemsInGroup(int) override
+    {
+        return (int)fetched;
+    }
+    bool hasMoreItems(int) override
+    {
+        return fetched < total;
+    }
+protected:
+    void fetchMoreItems(int group) override
+    {
+        const auto count = std::min<size_t>(total - fetched, pageSize);
+        fetched += count;
+        itemsFetched(group, count);
+    }
+
+    // ListViewDelegate interface
+public:
+    int heightForIndex(const ListIndex& index, int) override
+    {
+        return index.isHeader() ? 0 : 48;
+    }
+    const QMetaObject* viewMetaObjectForIndex(const ListIndex&) override
+    {
+        return &ListViewItem::staticMetaObject;
+    }
+
+private:
+    size_t total;
+    size_t pageSize;
+    size_t fetched;
+};
+
+#endif // BENCHMODEL_H
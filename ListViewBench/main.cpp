@@ -0,0 +1,650 @@
+#include "benchmodel.h"
+#include "verifier.h"
+#include "ListView/listviewtrace.h"
+#include "ListView/listtextmeasurer.h"
+#include "ListView/listdatacache.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+/**
+ * ListView 基准测试
+ * 在 offscreen 平台下，对 1k ~ 10M 行的合成数据模型测量 ListView 的核心操作耗时，
+ * 每个测量结果输出为一行 JSON (JSON Lines)，便于在不同版本之间比较回归。
+ */
+
+namespace
+{
+
+struct Options
+{
+    std::vector<size_t> rows = {1000, 10000, 100000, 1000000, 10000000};
+    bool rowsSpecified = false;
+    std::vector<BenchModel::Distribution> dists = {BenchModel::Uniform, BenchModel::Random, BenchModel::Bimodal};
+    int groupSize = 1000;
+    bool groupSizeSpecified = false;
+    bool headers = false;
+    ListView::LayoutMode layout = ListView::ListLayout;
+    ListView::AnchorMode anchor = ListView::AnchorTop;
+    int width = 400;
+    int height = 800;
+    // 已转义为 JSON 字符串的内容
+    std::string label;
+    std::string output;
+    std::string trace;
+    int verifySteps = 0;
+};
+
+std::vector<std::string> splitList(const char* text)
+{
+    std::vector<std::string> result;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ','))
+    {
+        if (!part.empty())
+        {
+            result.push_back(part);
+        }
+    }
+    return result;
+}
+
+// 转义为 JSON 字符串的内容（不含两端的引号），用于直接写入 JSON 输出
+std::string jsonEscape(const char* text)
+{
+    std::string result;
+    for (auto p = text; *p; p++)
+    {
+        const auto c = (unsigned char)*p;
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += char(c);
+        }
+        else if (c < 0x20)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            result += buffer;
+        }
+        else
+        {
+            result += char(c);
+        }
+    }
+    return result;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        auto arg = argv[i];
+        auto hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--rows") && hasValue)
+        {
+            options.rows.clear();
+            options.rowsSpecified = true;
+            for (auto& value : splitList(argv[++i]))
+            {
+                // 不是完整的非负整数时打印用法，而不是抛出异常
+                char* end = nullptr;
+                errno = 0;
+                const auto rows = strtoull(value.c_str(), &end, 10);
+                if (value[0] == '-' || *end || errno == ERANGE)
+                {
+                    fprintf(stderr, "invalid row count: %s\n", value.c_str());
+                    return false;
+                }
+                options.rows.push_back(rows);
+            }
+        }
+        else if (!strcmp(arg, "--dists") && hasValue)
+        {
+            options.dists.clear();
+            for (auto& value : splitList(argv[++i]))
+            {
+                BenchModel::Distribution dist;
+                if (!BenchModel::parseDistribution(value, dist))
+                {
+                    fprintf(stderr, "unknown distribution: %s\n", value.c_str());
+                    return false;
+                }
+                options.dists.push_back(dist);
+            }
+        }
+        else if (!strcmp(arg, "--group-size") && hasValue)
+        {
+            options.groupSize = std::max(1, atoi(argv[++i]));
+            options.groupSizeSpecified = true;
+        }
+        else if (!strcmp(arg, "--headers"))
+        {
+            options.headers = true;
+        }
+        else if (!strcmp(arg, "--layout") && hasValue)
+        {
+            auto name = argv[++i];
+            if (!strcmp(name, "list"))
+                options.layout = ListView::ListLayout;
+            else if (!strcmp(name, "grid"))
+                options.layout = ListView::GridLayout;
+            else if (!strcmp(name, "masonry"))
+                options.layout = ListView::MasonryLayout;
+            else
+            {
+                fprintf(stderr, "unknown layout: %s\n", name);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--anchor") && hasValue)
+        {
+            auto name = argv[++i];
+            if (!strcmp(name, "top"))
+                options.anchor = ListView::AnchorTop;
+            else if (!strcmp(name, "bottom"))
+                options.anchor = ListView::AnchorBottom;
+            else
+            {
+                fprintf(stderr, "unknown anchor: %s\n", name);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--label") && hasValue)
+        {
+            options.label = jsonEscape(argv[++i]);
+        }
+        else if (!strcmp(arg, "--output") && hasValue)
+        {
+            options.output = argv[++i];
+        }
+        else if (!strcmp(arg, "--trace") && hasValue)
+        {
+            options.trace = argv[++i];
+        }
+        else if (!strcmp(arg, "--verify") && hasValue)
+        {
+            options.verifySteps = std::max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--rows 1000,10000,...] [--dists uniform,random,bimodal]\n"
+                    "          [--group-size N] [--headers] [--layout list|grid|masonry] [--anchor top|bottom]\n"
+                    "          [--label NAME] [--output FILE] [--trace FILE]\n"
+                    "          [--verify STEPS]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 收集一组耗时样本，输出 mean / p50 / p95 / max
+ */
+class Samples
+{
+public:
+    void add(qint64 ns)
+    {
+        values.push_back(ns);
+    }
+
+    std::string json()
+    {
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (auto v : values)
+        {
+            sum += v;
+        }
+        auto percentile = [this](double p)
+        {
+            auto pos = size_t(p * (values.size() - 1) + 0.5);
+            return values[pos] / 1000.0;
+        };
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer),
+                 "\"iterations\":%zu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p95_us\":%.3f,\"max_us\":%.3f",
+                 values.size(), sum / values.size() / 1000.0, percentile(0.5), percentile(0.95), values.back() / 1000.0);
+        return buffer;
+    }
+
+private:
+    std::vector<qint64> values;
+};
+
+class BenchRunner
+{
+public:
+    BenchRunner(const Options& options, FILE* out) : options(options), out(out) {}
+
+    void run(BenchModel::Distribution dist, size_t rows)
+    {
+        this->dist = dist;
+        this->rows = rows;
+
+        BenchModel model(dist, rows, options.groupSize, options.headers);
+        ListView view(nullptr);
+        view.resize(options.width, options.height);
+        view.show();
+        if (options.layout != ListView::ListLayout)
+        {
+            model.setPreferredItemWidth(BenchGridItemWidth);
+            view.setLayoutMode(options.layout);
+        }
+        view.setAnchorMode(options.anchor);
+        view.setViewDelegate(&model);
+
+        // 首次设置数据模型即一次完整加载
+        measureOnce("set_model", [&] { view.setDataModel(&model); });
+
+        // 同一数据模型上的第二个同宽视图共享高度缓存，加载时不再测量
+        {
+            ListView shared(nullptr);
+            shared.resize(options.width, options.height);
+            shared.show();
+            shared.setLayoutMode(options.layout);
+            shared.setViewDelegate(&model);
+            measureOnce("set_model_shared", [&] { shared.setDataModel(&model); });
+        }
+
+        // 启动时用上次保存的快照恢复，不再测量；不共享高度缓存，以免直接使用 view 的缓存
+        {
+            model.setShareHeights(false);
+            const auto snapshot = view.saveLayoutSnapshot();
+            ListView restored(nullptr);
+            restored.resize(options.width, options.height);
+            restored.show();
+            restored.setLayoutMode(options.layout);
+            restored.setViewDelegate(&model);
+            restored.restoreLayoutSnapshot(snapshot);
+            measureOnce("set_model_snapshot", [&] { restored.setDataModel(&model); });
+            model.setShareHeights(true);
+        }
+
+        auto vs = view.findChild<QScrollBar*>();
+        auto& rng = model.random();
+        const int iterations = rows >= 1000000 ? 5 : 20;
+
+        measure("reload", iterations, [&] { model.reset(); });
+
+        // 在两个数据模型之间来回切换（例如邮件文件夹），切换回来时恢复保存的布局状态
+        {
+            BenchModel other(dist, 0, options.groupSize, false);
+            view.setModelCacheSize(1);
+            measure("switch_model_cached", iterations, [&] {
+                view.setDataModel(&other);
+                view.setDataModel(&model);
+            });
+            view.setModelCacheSize(0);
+        }
+
+        measure("scroll_to_item", 200, [&] { view.scrollToItem(model.randomIndex()); });
+
+        measure("scrollbar_jump", 200, [&] { vs->setValue(int(rng() % (unsigned)(vs->maximum() + 1))); });
+
+        // 模拟 SmoothScrollArea 的惯性滚动：每 10ms 一帧，速度逐帧衰减
+        vs->setValue(vs->maximum() / 2);
+        double speed = 60.0;
+        measure("wheel_frame", 600, [&] {
+            vs->setValue(vs->value() + int(speed));
+            speed = speed > 2 ? speed * 0.99 : 60.0;
+        });
+
+        // 数据层按可见范围安排加载：查询可见范围、随机位置的索引及其矩形
+        measure("visible_range_query", 200, [&] {
+            const auto range = view.visibleRange();
+            const auto index = view.indexAt(QPoint(int(rng() % (unsigned)view.width()), int(rng() % (unsigned)view.height())));
+            view.itemRect(index.isEmpty() ? range.first : index);
+        });
+
+        measure("item_updated_random", 200, [&] {
+            model.setHeight(model.randomIndex(), model.nextHeight());
+        });
+
+        measure("item_updated_visible", 200, [&] { view.scrollToItem(ListIndex(0, 0)); }, [&] {
+            model.setHeight(ListIndex(0, int(rng() % 8)), model.nextHeight());
+        });
+
+        // 行情刷新：一帧内对可见的数据项做 500 次更新，有一半改变高度，计时包含一次合并通知
+        measure("item_updated_storm", 20, [&] { view.scrollToItem(ListIndex(0, 0)); }, [&] {
+            model.setCoalescing(true);
+            for (int i = 0; i < 500; i++)
+            {
+                const ListIndex index(0, int(rng() % std::min(16, model.numItemsInGroup(0))));
+                if (i % 2)
+                {
+                    model.touch(index);
+                }
+                else
+                {
+                    model.setHeight(index, model.nextHeight());
+                }
+            }
+            model.flush();
+            model.setCoalescing(false);
+        });
+
+        // 整段刷新：一个分组内的连续数据项（最多 5000 个）一次通知
+        measure("items_updated_range", 20, [&] {
+            auto group = model.randomIndex().group;
+            model.refreshItems(ListIndex(group, 0), std::min(5000, model.numItemsInGroup(group)));
+        });
+
+        // 折叠与展开视口所在的分组，计时只包含布局与视图调整
+        measure("collapse_group", 100, [&] {
+            const auto range = view.visibleRange();
+            if (!range.isEmpty())
+            {
+                const auto group = range.first.group;
+                view.setGroupCollapsed(group, !view.isGroupCollapsed(group));
+            }
+        });
+
+        measure("insert_items", 100, [&] {
+            auto index = model.randomIndex();
+            model.insertItems(index, 1 + int(rng() % 10));
+        });
+
+        measure("remove_items", 100, [&] {
+            auto index = model.randomIndex();
+            auto count = std::min(1 + int(rng() % 10), model.numItemsInGroup(index.group) - index.item);
+            model.removeItems(index, count);
+        });
+
+        // 聊天记录向前加载：在开头插入一批历史消息
+        measure("prepend_history", 100, [&] {
+            model.insertItems(ListIndex(0, 0), 20);
+        });
+
+        // 日志流：每帧追加一批数据项并按保留上限丢弃最早的数据项，计时包含一次通知
+        model.setRetention(int(rows));
+        measure("stream_frame", 100, [&] {
+            model.streamItems(200, options.groupSize);
+            model.flush();
+        });
+        model.setRetention(0);
+
+        // 后台标签页：暂停期间的一批修改在恢复时一次性应用
+        measure("resume_journal", 20, [&] {
+            view.setSuspended(true);
+            for (int i = 0; i < 50; i++)
+            {
+                model.insertItems(model.randomIndex(), 1);
+                model.setHeight(model.randomIndex(), model.nextHeight());
+            }
+            view.setSuspended(false);
+        });
+
+        measure("insert_group", 20, [&] {
+            model.insertGroup(int(rng() % (model.numGroups() + 1)), options.groupSize);
+        });
+
+        measure("remove_group", 20, [&] {
+            if (model.numGroups() > 1)
+            {
+                model.removeGroup(int(rng() % model.numGroups()));
+            }
+        });
+
+        measure("set_selection", 20, [&] {
+            std::list<ListIndex> selection;
+            auto group = int(rng() % model.numGroups());
+            for (int item = 0; item < model.numItemsInGroup(group); item++)
+            {
+                selection.push_back(ListIndex(group, item));
+            }
+            view.setSelection(selection);
+        });
+
+        bool wide = false;
+        measure("width_relayout", rows >= 1000000 ? 3 : 10, [&] {
+            wide = !wide;
+            view.resize(options.width + (wide ? 40 : 0), options.height);
+        });
+
+        // 分页数据缓存：未命中时在 UI 线程同步加载一页；预取可见范围附近的页之后，取数据直接命中内存
+        {
+            ListDataCache<quint64> cache(&model, [](int group, int first, int count) {
+                std::vector<quint64> items(count);
+                for (int i = 0; i < count; i++)
+                {
+                    items[i] = (quint64(group) << 32) | quint64(first + i);
+                }
+                return items;
+            });
+            measure("data_cache_miss", 200, [&] {
+                cache.clear();
+                cache.item(model.randomIndex());
+            });
+            const auto range = view.visibleRange();
+            if (!range.isEmpty())
+            {
+                cache.prefetch(range.first, range.last);
+                cache.waitForPrefetch();
+                measure("data_cache_hit", 200, [&] {
+                    auto index = range.first;
+                    index.item = std::min(std::max(0, index.item) + int(rng() % 8), model.numItemsInGroup(index.group) - 1);
+                    cache.item(index);
+                });
+            }
+        }
+
+        // 文本测量服务：一批不重复的文本并行排版，再次测量时全部命中缓存
+        {
+            std::vector<QString> texts(std::min<size_t>(rows, 20000));
+            for (size_t i = 0; i < texts.size(); i++)
+            {
+                texts[i] = QString::number(int(i)) + QStringLiteral(" lorem ipsum dolor sit amet").repeated(1 + int(rng() % 8));
+            }
+            ListTextMeasurer measurer(view.font());
+            measureOnce("text_measure_all", [&] { measurer.measureAll(texts, options.width); });
+            measureOnce("text_measure_cached", [&] { measurer.measureAll(texts, options.width); });
+        }
+
+        // 分页加载：总数对视图未知，首屏只有一页；每次滚动到底部后，下一次事件循环中取得下一页
+        {
+            BenchPagedModel paged(rows, 100);
+            ListView pagedView(nullptr);
+            pagedView.resize(options.width, options.height);
+            pagedView.show();
+            pagedView.setViewDelegate(&paged);
+            measureOnce("paged_set_model", [&] { pagedView.setDataModel(&paged); });
+            auto pagedBar = pagedView.findChild<QScrollBar*>();
+            measure("paged_fetch_page", 50, [&] {
+                pagedBar->setValue(pagedBar->maximum());
+                QCoreApplication::processEvents();
+            });
+        }
+
+        // 树形模型：第一层 rows 个节点，展开与折叠有 1000 个子节点的节点，以及可见行到节点路径的换算
+        {
+            BenchTreeModel tree((int)rows, 1000);
+            ListView treeView(nullptr);
+            treeView.resize(options.width, options.height);
+            treeView.show();
+            treeView.setViewDelegate(&tree);
+            treeView.setDataModel(&tree);
+            measure("tree_toggle", 20, [&] {
+                const ListTreePath node{int(rng() % (unsigned)tree.numRoots())};
+                tree.setExpanded(node, !tree.isExpanded(node));
+            });
+            // 展开一些第二层的节点，使换算跨越三层
+            for (int i = 0; i < 100; i++)
+            {
+                const auto root = int(rng() % (unsigned)tree.numRoots());
+                tree.setExpanded(ListTreePath{root}, true);
+                tree.setExpanded(ListTreePath{root, int(rng() % 1000)}, true);
+            }
+            measure("tree_map_index", 200, [&] {
+                tree.pathForIndex(ListIndex(0, int(rng() % (unsigned)tree.numItemsInGroup(0))));
+            });
+        }
+
+        reportStats(view.stats());
+    }
+
+private:
+    void measureOnce(const char* name, const std::function<void()>& op)
+    {
+        measure(name, 1, op);
+    }
+
+    void measure(const char* name, int iterations, const std::function<void()>& op)
+    {
+        measure(name, iterations, nullptr, op);
+    }
+
+    // 每次迭代前调用 setup 准备状态，setup 的耗时不计入测量
+    void measure(const char* name, int iterations, const std::function<void()>& setup, const std::function<void()>& op)
+    {
+        Samples samples;
+        QElapsedTimer timer;
+        for (int i = 0; i < iterations; i++)
+        {
+            if (setup)
+            {
+                setup();
+            }
+            timer.start();
+            op();
+            samples.add(timer.nsecsElapsed());
+        }
+        // 让延迟删除的视图等事件得到处理，避免影响下一项测量
+        QCoreApplication::processEvents();
+        report(name, samples);
+    }
+
+    void report(const char* name, Samples& samples)
+    {
+        fprintf(out, "{\"label\":\"%s\",\"bench\":\"%s\",\"dist\":\"%s\",\"rows\":%zu,%s}\n",
+                options.label.c_str(), name, BenchModel::distributionName(dist), rows, samples.json().c_str());
+        fflush(out);
+    }
+
+    void reportStats(const ListViewStats& stats)
+    {
+        size_t pooled = 0;
+        for (auto& pair : stats.reusePoolSizes)
+        {
+            pooled += pair.second;
+        }
+        fprintf(out, "{\"label\":\"%s\",\"bench\":\"stats\",\"dist\":\"%s\",\"rows\":%zu,"
+                     "\"layout_passes\":%llu,\"views_created\":%llu,\"views_reused\":%llu,\"views_cleaned\":%llu,\"pooled_views\":%zu,"
+                     "\"height_for_index_calls\":%llu,\"height_for_index_us\":%.3f,"
+                     "\"prepare_heights_calls\":%llu,\"prepare_heights_us\":%.3f,"
+                     "\"prepare_item_view_calls\":%llu,\"prepare_item_view_us\":%.3f,"
+                     "\"max_adjust_us\":%.3f,\"passes_over_budget\":%llu}\n",
+                options.label.c_str(), BenchModel::distributionName(dist), rows,
+                (unsigned long long)stats.layoutPasses, (unsigned long long)stats.viewsCreated,
+                (unsigned long long)stats.viewsReused, (unsigned long long)stats.viewsCleaned, pooled,
+                (unsigned long long)stats.heightForIndexCalls, stats.heightForIndexNs / 1000.0,
+                (unsigned long long)stats.prepareHeightsCalls, stats.prepareHeightsNs / 1000.0,
+                (unsigned long long)stats.prepareItemViewCalls, stats.prepareItemViewNs / 1000.0,
+                stats.maxAdjustLoadedItemsNs / 1000.0, (unsigned long long)stats.passesOverBudget);
+        fflush(out);
+    }
+
+    const Options& options;
+    FILE* out;
+    BenchModel::Distribution dist = BenchModel::Uniform;
+    size_t rows = 0;
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication a(argc, argv);
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (!options.output.empty())
+    {
+        out = fopen(options.output.c_str(), "w");
+        if (!out)
+        {
+            fprintf(stderr, "cannot open %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+
+    if (!options.trace.empty() && !ListViewTrace::start())
+    {
+        fprintf(stderr, "tracing is not compiled in (LISTVIEW_TRACE)\n");
+    }
+
+    int failures = 0;
+    if (options.verifySteps)
+    {
+        // 校验模式：随机修改数据并检查布局不变式与代价上界，有失败时返回非 0
+        Verifier::Config config;
+        config.headers = options.headers;
+        config.layout = options.layout;
+        config.anchor = options.anchor;
+        config.width = options.width;
+        config.height = options.height;
+        config.label = options.label;
+        if (options.groupSizeSpecified)
+        {
+            config.groupSize = options.groupSize;
+        }
+        if (!options.rowsSpecified)
+        {
+            options.rows = {2000};
+        }
+        Verifier verifier(config, out);
+        for (auto rows : options.rows)
+        {
+            for (auto dist : options.dists)
+            {
+                failures += verifier.run(dist, rows, options.verifySteps);
+            }
+        }
+        failures += verifier.runTree(options.verifySteps);
+    }
+    else
+    {
+        BenchRunner runner(options, out);
+        for (auto rows : options.rows)
+        {
+            for (auto dist : options.dists)
+            {
+                runner.run(dist, rows);
+            }
+        }
+    }
+
+    if (ListViewTrace::isEnabled())
+    {
+        ListViewTrace::stop();
+        if (!ListViewTrace::writeTo(QString::fromLocal8Bit(options.trace.c_str())))
+        {
+            fprintf(stderr, "cannot write %s\n", options.trace.c_str());
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,990 @@
+#include "verifier.h"
+#include "ListView/listview_p.h"
+#include "ListView/listdatacache.h"
+#include "ListView/listfiltermodel.h"
+#include "ListView/listsortmodel.h"
+
+#include <QCoreApplication>
+#include <QScrollBar>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace
+{
+
+/**
+ * 按照 ListView 的规则维护一份期望的选中列表
+ */
+class ExpectedSelection
+{
+public:
+    void set(const std::list<ListIndex>& selection)
+    {
+        indexes = selection;
+    }
+
+    const std::list<ListIndex>& get() const
+    {
+        return indexes;
+    }
+
+    void itemsInserted(const ListIndex& index, int count)
+    {
+        for (auto& selected : indexes)
+        {
+            if (selected.group == index.group && selected.item >= index.item)
+            {
+                selected.item += count;
+            }
+        }
+    }
+
+    void itemsRemoved(const ListIndex& index, int count)
+    {
+        for (auto it = indexes.begin(); it != indexes.end(); )
+        {
+            if (it->group == index.group && it->item >= index.item)
+            {
+                if (it->item < index.item + count)
+                {
+                    it = indexes.erase(it);
+                    continue;
+                }
+                it->item -= count;
+            }
+            it++;
+        }
+    }
+
+    void groupInserted(int group)
+    {
+        for (auto& selected : indexes)
+        {
+            if (selected.group >= group)
+            {
+                selected.group++;
+            }
+        }
+    }
+
+    void groupRemoved(int group)
+    {
+        for (auto it = indexes.begin(); it != indexes.end(); )
+        {
+            if (it->group == group)
+            {
+                it = indexes.erase(it);
+                continue;
+            }
+            if (it->group > group)
+            {
+                it->group--;
+            }
+            it++;
+        }
+    }
+
+private:
+    std::list<ListIndex> indexes;
+};
+
+/**
+ * 与暴力重新计算的结果对比过滤代理模型，要求过滤已经完成：
+ * 每个分组中的数据项恰好是满足条件的源数据项并按源索引升序排列，mapToSource 与 mapFromSource 互逆，
+ * 被过滤掉的数据项映射为空索引
+ */
+QString checkFilterModel(BenchModel& source, ListFilterModel& filter, const ListFilterModel::Predicate& predicate)
+{
+    if (filter.numGroups() != source.numGroups())
+    {
+        return QString::asprintf("filter has %d groups, source has %d", filter.numGroups(), source.numGroups());
+    }
+    for (int group = 0; group < source.numGroups(); group++)
+    {
+        const auto numItems = source.numItemsInGroup(group);
+        int pos = 0;
+        for (int item = 0; item < numItems; item++)
+        {
+            const auto sourceIndex = ListIndex(group, item);
+            const auto mapped = filter.mapFromSource(sourceIndex);
+            if (!predicate(sourceIndex))
+            {
+                if (!mapped.isEmpty())
+                {
+                    return QString::asprintf("rejected source item (%d,%d) maps to (%d,%d)", group, item, mapped.group, mapped.item);
+                }
+                continue;
+            }
+            if (pos >= filter.numItemsInGroup(group) || filter.mapToSource(ListIndex(group, pos)) != sourceIndex)
+            {
+                return QString::asprintf("filter row (%d,%d) should map to source item %d", group, pos, item);
+            }
+            if (mapped != ListIndex(group, pos))
+            {
+                return QString::asprintf("source item (%d,%d) maps to (%d,%d), expected (%d,%d)", group, item, mapped.group, mapped.item, group, pos);
+            }
+            pos++;
+        }
+        if (filter.numItemsInGroup(group) != pos)
+        {
+            return QString::asprintf("filter group %d has %d items, expected %d", group, filter.numItemsInGroup(group), pos);
+        }
+    }
+    return QString();
+}
+
+/**
+ * 与暴力排序的结果对比排序代理模型（不排序分组）：
+ * 每个分组中的数据项按 itemLess 排列，相等时按源索引排列，mapToSource 与 mapFromSource 互逆
+ */
+QString checkSortModel(BenchModel& source, ListSortModel& sort, const ListSortModel::ItemLess& itemLess)
+{
+    if (sort.numGroups() != source.numGroups())
+    {
+        return QString::asprintf("sort model has %d groups, source has %d", sort.numGroups(), source.numGroups());
+    }
+    for (int group = 0; group < source.numGroups(); group++)
+    {
+        std::vector<int> expectedRows(source.numItemsInGroup(group));
+        for (int item = 0; item < (int)expectedRows.size(); item++)
+        {
+            expectedRows[item] = item;
+        }
+        std::sort(expectedRows.begin(), expectedRows.end(), [&itemLess, group](int a, int b){
+            return itemLess(ListIndex(group, a), ListIndex(group, b)) || (!itemLess(ListIndex(group, b), ListIndex(group, a)) && a < b);
+        });
+        if (sort.numItemsInGroup(group) != (int)expectedRows.size())
+        {
+            return QString::asprintf("sort group %d has %d items, expected %d", group, sort.numItemsInGroup(group), (int)expectedRows.size());
+        }
+        for (int pos = 0; pos < (int)expectedRows.size(); pos++)
+        {
+            const auto mapped = sort.mapToSource(ListIndex(group, pos));
+            if (mapped != ListIndex(group, expectedRows[pos]))
+            {
+                return QString::asprintf("sorted row (%d,%d) maps to (%d,%d), expected (%d,%d)",
+                                         group, pos, mapped.group, mapped.item, group, expectedRows[pos]);
+            }
+            if (sort.mapFromSource(mapped) != ListIndex(group, pos))
+            {
+                return QString::asprintf("source item (%d,%d) does not map back to sorted row %d", mapped.group, mapped.item, pos);
+            }
+        }
+    }
+    return QString();
+}
+
+/**
+ * 显示代理模型的视图使用的 delegate ：视图测量高度或绑定数据时，代理模型的索引必须能映射到源模型中存在的数据项。
+ * 代理模型在通知视图之前没有更新好映射时，视图会在通知中重新布局并读到错误的源数据项，这里记录第一个出错的位置
+ */
+class ProxyCheckDelegate : public ListViewDelegate
+{
+public:
+    ProxyCheckDelegate(BenchModel& source, std::function<ListIndex(const ListIndex&)> mapToSource)
+        : source(source), mapToSource(std::move(mapToSource))
+    {
+    }
+
+    /**
+     * 返回并清空记录的错误
+     */
+    QString takeError()
+    {
+        QString result = error;
+        error = QString();
+        return result;
+    }
+
+    // ListViewDelegate interface
+public:
+    int heightForIndex(const ListIndex& index, int) override
+    {
+        const auto mapped = check(index, "heightForIndex");
+        return mapped.isEmpty() || mapped.isHeader() ? 0 : source.height(mapped);
+    }
+    const QMetaObject* viewMetaObjectForIndex(const ListIndex&) override
+    {
+        return &ListViewItem::staticMetaObject;
+    }
+    void prepareItemView(const ListIndex& index, ListViewItem*) override
+    {
+        check(index, "prepareItemView");
+    }
+
+private:
+    ListIndex check(const ListIndex& index, const char* caller)
+    {
+        const auto mapped = mapToSource(index);
+        const auto valid = mapped.group >= 0 && mapped.group < source.numGroups()
+                && (mapped.isHeader() || (mapped.item >= 0 && mapped.item < source.numItemsInGroup(mapped.group)));
+        if (valid)
+        {
+            return mapped;
+        }
+        if (error.isEmpty())
+        {
+            error = QString::asprintf("%s: proxy index (%d,%d) maps to missing source item (%d,%d)",
+                                      caller, index.group, index.item, mapped.group, mapped.item);
+        }
+        return ListIndex();
+    }
+
+    BenchModel& source;
+    std::function<ListIndex(const ListIndex&)> mapToSource;
+    QString error;
+};
+
+/**
+ * 校验用的树形数据模型：完整的树保存在内存中，同时记录每个节点的期望展开状态，
+ * 按展开状态直接展平得到的行作为 ListTreeModel 换算结果的参照
+ */
+class VerifyTreeModel : public ListTreeModel, public ListViewDelegate
+{
+public:
+    struct Node
+    {
+        bool expanded = false;
+        std::vector<Node> children;
+    };
+
+    explicit VerifyTreeModel(std::mt19937& rng) : rng(rng)
+    {
+        root.expanded = true;
+        grow(root, 0);
+    }
+
+    Node& node(const ListTreePath& path)
+    {
+        auto result = &root;
+        for (auto position : path)
+        {
+            result = &result->children[position];
+        }
+        return *result;
+    }
+
+    /**
+     * 从根节点开始随机向下走，返回经过的某个节点的路径（可能是根节点）
+     */
+    ListTreePath randomPath()
+    {
+        ListTreePath path;
+        auto current = &root;
+        while (!current->children.empty() && (path.empty() || rng() % 3))
+        {
+            path.push_back(int(rng() % current->children.size()));
+            current = &current->children[path.back()];
+        }
+        return path;
+    }
+
+    /**
+     * 按期望的展开状态展平，hidden 收集部分不可见节点（折叠节点的第一个子节点）的路径
+     */
+    void flatten(std::vector<ListTreePath>& rows, std::vector<ListTreePath>& hidden)
+    {
+        ListTreePath path;
+        flatten(root, path, rows, hidden);
+    }
+
+    void toggle(const ListTreePath& path)
+    {
+        auto& target = node(path);
+        target.expanded = !target.expanded;
+        setExpanded(path, target.expanded);
+    }
+
+    void insertChildren(const ListTreePath& path, int row, int count)
+    {
+        auto& parent = node(path);
+        std::vector<Node> inserted(count);
+        for (auto& child : inserted)
+        {
+            grow(child, (int)path.size() + 1);
+        }
+        beginInsertChildren(path, row, count);
+        parent.children.insert(parent.children.begin() + row, inserted.begin(), inserted.end());
+        endInsertChildren();
+    }
+
+    void removeChildren(const ListTreePath& path, int row, int count)
+    {
+        auto& parent = node(path);
+        beginRemoveChildren(path, row, count);
+        parent.children.erase(parent.children.begin() + row, parent.children.begin() + row + count);
+        endRemoveChildren();
+    }
+
+    void touch(const ListTreePath& path)
+    {
+        nodeUpdated(path);
+    }
+
+    // ListTreeModel interface
+public:
+    int numChildren(const ListTreePath& parent) override
+    {
+        return (int)node(parent).children.size();
+    }
+
+    // ListViewDelegate interface
+public:
+    int heightForIndex(const ListIndex& index, int) override
+    {
+        return index.isHeader() ? 0 : 32;
+    }
+    const QMetaObject* viewMetaObjectForIndex(const ListIndex&) override
+    {
+        return &ListViewItem::staticMetaObject;
+    }
+
+private:
+    void grow(Node& parent, int depth)
+    {
+        const auto count = depth == 0 ? 20 + int(rng() % 20) : (depth < 4 && rng() % 2) ? int(rng() % 6) : 0;
+        parent.children.resize(count);
+        for (auto& child : parent.children)
+        {
+            grow(child, depth + 1);
+        }
+    }
+
+    void flatten(const Node& parent, ListTreePath& path, std::vector<ListTreePath>& rows, std::vector<ListTreePath>& hidden)
+    {
+        for (int position = 0; position < (int)parent.children.size(); position++)
+        {
+            const auto& child = parent.children[position];
+            path.push_back(position);
+            rows.push_back(path);
+            if (child.expanded)
+            {
+                flatten(child, path, rows, hidden);
+            }
+            else if (!child.children.empty())
+            {
+                path.push_back(0);
+                hidden.push_back(path);
+                path.pop_back();
+            }
+            path.pop_back();
+        }
+    }
+
+    std::mt19937& rng;
+    Node root;
+};
+
+}
+
+int Verifier::run(BenchModel::Distribution dist, size_t rows, int steps)
+{
+    BenchModel model(dist, rows, config.groupSize, config.headers, config.seed);
+    ListView view(nullptr);
+    view.resize(config.width, config.height);
+    view.show();
+    if (config.layout != ListView::ListLayout)
+    {
+        model.setPreferredItemWidth(BenchGridItemWidth);
+        view.setLayoutMode(config.layout);
+    }
+    view.setAnchorMode(config.anchor);
+    view.setViewDelegate(&model);
+    view.setDataModel(&model);
+    auto& rng = model.random();
+
+    // 代理模型与视图同时观察同一个源模型，每一步之后与暴力重新计算的结果对比
+    // 块较小，使初始过滤与新增分组的过滤都分成多块完成
+    ListFilterModel::Predicate predicate = [&model](const ListIndex& index){return model.height(index) % 3 != 1;};
+    ListFilterModel filter;
+    filter.setChunkSize(64);
+    filter.setSourceModel(&model);
+    filter.setFilter(predicate);
+    // 按高度分档排序，同一档内有大量相等的数据项，检验按源索引排列的规则
+    ListSortModel::ItemLess itemLess = [&model](const ListIndex& a, const ListIndex& b){return model.height(a) / 16 < model.height(b) / 16;};
+    ListSortModel sort;
+    sort.setSourceModel(&model);
+    sort.setSortOrder(itemLess);
+    // 两个代理模型各自显示在一个视图中：源模型不在批量修改中时删除数据项或分组，代理模型的通知会立即使视图重新布局，
+    // 此时映射必须已经更新。每一步随机滚动这两个视图，使删除位置之后以及末尾的行经常处于加载状态
+    ProxyCheckDelegate filterDelegate(model, [&filter](const ListIndex& index){return filter.mapToSource(index);});
+    ListView filterView(nullptr);
+    filterView.resize(config.width, config.height);
+    filterView.show();
+    filterView.setViewDelegate(&filterDelegate);
+    filterView.setDataModel(&filter);
+    ProxyCheckDelegate sortDelegate(model, [&sort](const ListIndex& index){return sort.mapToSource(index);});
+    ListView sortView(nullptr);
+    sortView.resize(config.width, config.height);
+    sortView.show();
+    sortView.setViewDelegate(&sortDelegate);
+    sortView.setDataModel(&sort);
+    auto scrollProxyViews = [&]
+    {
+        for (auto proxyView : {&filterView, &sortView})
+        {
+            auto bar = proxyView->findChild<QScrollBar*>();
+            bar->setValue(rng() % 3 == 0 ? bar->maximum() : int(rng() % (unsigned)(bar->maximum() + 1)));
+        }
+    };
+
+    // 过滤条件在工作线程中读取高度：直接修改高度之前、以及校验完整结果之前，先等待过滤完成
+    auto settle = [&filter]
+    {
+        while (filter.isFiltering())
+        {
+            QCoreApplication::processEvents();
+            std::this_thread::yield();
+        }
+    };
+
+    auto vs = view.findChild<QScrollBar*>();
+    ExpectedSelection expected;
+    int failures = 0;
+
+    auto fail = [&](int step, const char* op, const QString& message)
+    {
+        failures++;
+        fprintf(stderr, "[%s/%zu] step %d (%s): %s\n", BenchModel::distributionName(dist), rows, step, op, message.toUtf8().constData());
+    };
+
+    // 单步允许生成的视图上限，多列布局下按每列分别计算
+    const int columns = config.layout != ListView::ListLayout ? std::max(1, (config.width + 80) / BenchGridItemWidth) : 1;
+    auto viewBudget = [&](int distance)
+    {
+        return quint64(distance / model.minHeight() + 2) * columns;
+    };
+
+    for (int step = 0; step < steps && failures < 10; step++)
+    {
+        scrollProxyViews();
+        const auto before = view.stats();
+        const char* op = "";
+        qint64 expectedMeasures = -1;
+        quint64 maxGeneratedViews = ~quint64(0);
+
+        auto op_id = model.totalRows() == 0 ? 4 : int(rng() % 16);
+        switch (op_id)
+        {
+        case 0:
+        {
+            op = "scroll_step";
+            int distance = int(rng() % (config.height / 2)) + 1;
+            vs->setValue(vs->value() + ((rng() & 1) ? distance : -distance));
+            expectedMeasures = 0;
+            maxGeneratedViews = viewBudget(distance);
+            break;
+        }
+        case 1:
+        {
+            op = "scroll_jump";
+            vs->setValue(int(rng() % (unsigned)(vs->maximum() + 1)));
+            expectedMeasures = 0;
+            maxGeneratedViews = viewBudget(config.height);
+            break;
+        }
+        case 2:
+        {
+            op = "insert_items";
+            auto group = int(rng() % model.numGroups());
+            auto index = ListIndex(group, int(rng() % (model.numItemsInGroup(group) + 1)));
+            auto count = 1 + int(rng() % 20);
+            model.insertItems(index, count);
+            expected.itemsInserted(index, count);
+            expectedMeasures = count;
+            break;
+        }
+        case 3:
+        {
+            op = "remove_items";
+            auto index = model.randomIndex();
+            auto count = std::min(1 + int(rng() % 20), model.numItemsInGroup(index.group) - index.item);
+            model.removeItems(index, count);
+            expected.itemsRemoved(index, count);
+            expectedMeasures = 0;
+            break;
+        }
+        case 4:
+        {
+            op = "insert_group";
+            auto group = int(rng() % (model.numGroups() + 1));
+            auto count = int(rng() % 50);
+            model.insertGroup(group, count);
+            expected.groupInserted(group);
+            expectedMeasures = count;
+            break;
+        }
+        case 5:
+        {
+            op = "remove_group";
+            if (model.numGroups() <= 1)
+            {
+                continue;
+            }
+            auto group = int(rng() % model.numGroups());
+            model.removeGroup(group);
+            expected.groupRemoved(group);
+            expectedMeasures = 0;
+            break;
+        }
+        case 6:
+        case 7:
+        {
+            op = "item_updated";
+            settle();
+            model.setHeight(model.randomIndex(), model.nextHeight());
+            expectedMeasures = 1;
+            break;
+        }
+        case 8:
+        {
+            op = "set_selection";
+            std::set<ListIndex> picked;
+            auto n = int(rng() % 30);
+            for (int i = 0; i < n; i++)
+            {
+                picked.insert(model.randomIndex());
+            }
+            std::list<ListIndex> selection(picked.begin(), picked.end());
+            view.setSelection(selection);
+            expected.set(selection);
+            expectedMeasures = 0;
+            maxGeneratedViews = 0;
+            break;
+        }
+        case 9:
+        {
+            op = "resize_width";
+            auto width = config.width + int(rng() % 80);
+            // 数据项高度受宽度影响，宽度改变时需要重新测量全部数据项
+            expectedMeasures = width != view.width() ? (qint64)model.totalRows() : 0;
+            view.resize(width, config.height);
+            maxGeneratedViews = viewBudget(config.height);
+            break;
+        }
+        case 10:
+        {
+            // 暂停期间的一批修改只被记录，恢复时一次性应用
+            op = "suspended_burst";
+            view.setSuspended(true);
+            auto n = 1 + int(rng() % 8);
+            for (int i = 0; i < n && model.totalRows() > 0; i++)
+            {
+                switch (rng() % 5)
+                {
+                case 0:
+                {
+                    auto group = int(rng() % model.numGroups());
+                    auto index = ListIndex(group, int(rng() % (model.numItemsInGroup(group) + 1)));
+                    auto count = 1 + int(rng() % 20);
+                    model.insertItems(index, count);
+                    expected.itemsInserted(index, count);
+                    break;
+                }
+                case 1:
+                {
+                    auto index = model.randomIndex();
+                    auto count = std::min(1 + int(rng() % 20), model.numItemsInGroup(index.group) - index.item);
+                    model.removeItems(index, count);
+                    expected.itemsRemoved(index, count);
+                    break;
+                }
+                case 2:
+                {
+                    auto group = int(rng() % (model.numGroups() + 1));
+                    model.insertGroup(group, int(rng() % 50));
+                    expected.groupInserted(group);
+                    break;
+                }
+                case 3:
+                {
+                    if (model.numGroups() > 1)
+                    {
+                        auto group = int(rng() % model.numGroups());
+                        model.removeGroup(group);
+                        expected.groupRemoved(group);
+                    }
+                    break;
+                }
+                default:
+                    settle();
+                    model.setHeight(model.randomIndex(), model.nextHeight());
+                    break;
+                }
+            }
+            view.setSuspended(false);
+            maxGeneratedViews = viewBudget(config.height);
+            break;
+        }
+        case 11:
+        {
+            // 折叠与展开只修改分组的总高度，不重新测量
+            op = "toggle_collapse";
+            auto group = int(rng() % model.numGroups());
+            view.setGroupCollapsed(group, !view.isGroupCollapsed(group));
+            expectedMeasures = 0;
+            maxGeneratedViews = viewBudget(config.height);
+            break;
+        }
+        case 12:
+        {
+            // 来回滚动使回收的视图在空闲清理前被重新取出，再执行空闲清理：屏幕上的视图必须保持绑定
+            op = "scroll_idle_clean";
+            int distance = int(rng() % config.height) + 1;
+            auto n = 2 + int(rng() % 3);
+            for (int i = 0; i < n; i++)
+            {
+                vs->setValue(vs->value() + ((i & 1) ? -distance : distance));
+            }
+            view.getPriv()->cleanPooledViews(-1);
+            expectedMeasures = 0;
+            maxGeneratedViews = viewBudget(distance) * n;
+            break;
+        }
+        case 13:
+        {
+            // 多个线程同时提交修改，UI 线程在下一次事件循环中按提交顺序执行。
+            // 每个线程只在分组 0 的开头插入、删除或更新不超过自己已插入数目的数据项，或在最后一个分组末尾追加，
+            // 因此任意交错下索引都有效。期望的选中列表在修改实际执行时更新。
+            op = "post_burst";
+            struct Post
+            {
+                int type;
+                int count;
+                std::vector<int> heights;
+            };
+            std::vector<std::vector<Post>> plans(2 + rng() % 3);
+            auto expectedRows = model.totalRows();
+            size_t posts = 0;
+            for (auto& plan : plans)
+            {
+                auto owned = 0;
+                auto n = 1 + int(rng() % 8);
+                for (int i = 0; i < n; i++)
+                {
+                    Post post;
+                    post.type = int(rng() % 4);
+                    if (owned == 0 && (post.type == 1 || post.type == 2))
+                    {
+                        post.type = 0;
+                    }
+                    post.count = post.type == 1 ? 1 + int(rng() % owned) : 1 + int(rng() % 5);
+                    if (post.type != 1)
+                    {
+                        post.heights.resize(post.type == 2 ? 1 : post.count);
+                        for (auto& h : post.heights)
+                        {
+                            h = model.nextHeight();
+                        }
+                    }
+                    owned += post.type == 0 ? post.count : post.type == 1 ? -post.count : 0;
+                    expectedRows += post.type == 0 || post.type == 3 ? post.count : post.type == 1 ? -post.count : 0;
+                    plan.push_back(std::move(post));
+                }
+                posts += plan.size();
+            }
+
+            size_t applied = 0;
+            std::vector<std::thread> producers;
+            for (auto& plan : plans)
+            {
+                producers.emplace_back([&model, &expected, &applied, &plan]{
+                    const auto head = ListIndex(0, 0);
+                    for (auto& post : plan)
+                    {
+                        const auto count = post.count;
+                        if (post.type == 0)
+                        {
+                            model.postInsert(head, post.heights, [&expected, &applied, head, count]{expected.itemsInserted(head, count); applied++;});
+                        }
+                        else if (post.type == 1)
+                        {
+                            model.postRemove(head, count, [&expected, &applied, head, count]{expected.itemsRemoved(head, count); applied++;});
+                        }
+                        else if (post.type == 2)
+                        {
+                            model.postUpdate(head, post.heights.front(), [&applied]{applied++;});
+                        }
+                        else
+                        {
+                            model.postAppend(post.heights, [&applied]{applied++;});
+                        }
+                    }
+                });
+            }
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+            for (int i = 0; i < 100 && applied < posts; i++)
+            {
+                QCoreApplication::processEvents();
+            }
+            // 追加按帧合并通知，立即通知以便校验
+            model.flush();
+
+            if (applied != posts)
+            {
+                fail(step, op, QString::asprintf("%d of %d posted mutations applied", (int)applied, (int)posts));
+            }
+            if (model.totalRows() != expectedRows)
+            {
+                fail(step, op, QString::asprintf("%d rows after draining, expected %d", (int)model.totalRows(), (int)expectedRows));
+            }
+            break;
+        }
+        case 14:
+        {
+            // 区间更新：排序代理模型中更新项的位置可能整体改变
+            op = "items_updated";
+            settle();
+            auto first = model.randomIndex();
+            auto count = std::min(1 + int(rng() % 40), model.numItemsInGroup(first.group) - first.item);
+            model.refreshItems(first, count);
+            expectedMeasures = count;
+            break;
+        }
+        case 15:
+        {
+            // 分页缓存：预取整个分组，加载被挡住时在分组中插入或删除数据项并丢弃该分组，
+            // 之后每个数据项都要能按修改后的数目取到，超出末尾的索引取不到
+            op = "cache_invalidate";
+            std::atomic<bool> gate(false);
+            ListDataCache<quint64> cache(&model, [&gate](int group, int first, int count) {
+                while (!gate)
+                {
+                    std::this_thread::yield();
+                }
+                std::vector<quint64> items(count);
+                for (int i = 0; i < count; i++)
+                {
+                    items[i] = (quint64(group) << 32) | quint64(first + i);
+                }
+                return items;
+            }, 16);
+            const auto group = model.randomIndex().group;
+            cache.prefetch(ListIndex(group, 0), ListIndex(group, model.numItemsInGroup(group) - 1));
+            if (rng() & 1)
+            {
+                auto index = ListIndex(group, int(rng() % (model.numItemsInGroup(group) + 1)));
+                auto count = 1 + int(rng() % 20);
+                model.insertItems(index, count);
+                expected.itemsInserted(index, count);
+                expectedMeasures = count;
+            }
+            else
+            {
+                auto index = ListIndex(group, int(rng() % model.numItemsInGroup(group)));
+                auto count = std::min(1 + int(rng() % 20), model.numItemsInGroup(group) - index.item);
+                model.removeItems(index, count);
+                expected.itemsRemoved(index, count);
+                expectedMeasures = 0;
+            }
+            cache.invalidate(group);
+            gate = true;
+            cache.waitForPrefetch();
+
+            const auto numItems = model.numItemsInGroup(group);
+            for (int item = 0; item < numItems; item++)
+            {
+                auto value = cache.item(ListIndex(group, item));
+                if (!value || *value != ((quint64(group) << 32) | quint64(item)))
+                {
+                    fail(step, op, QString::asprintf("cached item (%d,%d) is missing or stale", group, item));
+                    break;
+                }
+            }
+            if (cache.item(ListIndex(group, numItems)))
+            {
+                fail(step, op, QString::asprintf("cache returns item (%d,%d) past the end of the group", group, numItems));
+            }
+            break;
+        }
+        }
+
+        const auto after = view.stats();
+        auto measures = after.heightForIndexCalls - before.heightForIndexCalls;
+        auto generated = (after.viewsCreated + after.viewsReused) - (before.viewsCreated + before.viewsReused);
+
+        auto error = view.getPriv()->verifyLayout();
+        if (!error.isEmpty())
+        {
+            fail(step, op, error);
+        }
+        if (expectedMeasures >= 0 && (qint64)measures != expectedMeasures)
+        {
+            fail(step, op, QString::asprintf("heightForIndex called %llu times, expected %lld",
+                                             (unsigned long long)measures, (long long)expectedMeasures));
+        }
+        if (generated > maxGeneratedViews)
+        {
+            fail(step, op, QString::asprintf("generated %llu views, budget %llu",
+                                             (unsigned long long)generated, (unsigned long long)maxGeneratedViews));
+        }
+        if (view.selection() != expected.get())
+        {
+            fail(step, op, QStringLiteral("selection differs from expected"));
+        }
+
+        error = filterDelegate.takeError();
+        if (!error.isEmpty())
+        {
+            fail(step, op, QStringLiteral("filter view: ") + error);
+        }
+        error = sortDelegate.takeError();
+        if (!error.isEmpty())
+        {
+            fail(step, op, QStringLiteral("sort view: ") + error);
+        }
+
+        settle();
+        error = checkFilterModel(model, filter, predicate);
+        if (!error.isEmpty())
+        {
+            fail(step, op, error);
+        }
+        error = checkSortModel(model, sort, itemLess);
+        if (!error.isEmpty())
+        {
+            fail(step, op, error);
+        }
+    }
+
+    QCoreApplication::processEvents();
+    fprintf(out, "{\"label\":\"%s\",\"bench\":\"verify\",\"dist\":\"%s\",\"rows\":%zu,\"steps\":%d,\"failures\":%d}\n",
+            config.label.c_str(), BenchModel::distributionName(dist), rows, steps, failures);
+    fflush(out);
+    return failures;
+}
+
+int Verifier::runTree(int steps)
+{
+    std::mt19937 rng(config.seed);
+    VerifyTreeModel model(rng);
+    ListView view(nullptr);
+    view.resize(config.width, config.height);
+    view.show();
+    view.setViewDelegate(&model);
+    view.setDataModel(&model);
+
+    auto vs = view.findChild<QScrollBar*>();
+    int failures = 0;
+    auto fail = [&](int step, const char* op, const QString& message)
+    {
+        failures++;
+        fprintf(stderr, "[tree] step %d (%s): %s\n", step, op, message.toUtf8().constData());
+    };
+
+    // 行与路径的换算、层级与展开状态都与按期望展开状态直接展平的结果对比
+    auto check = [&]() -> QString
+    {
+        std::vector<ListTreePath> rows;
+        std::vector<ListTreePath> hidden;
+        model.flatten(rows, hidden);
+        if (model.numItemsInGroup(0) != (int)rows.size())
+        {
+            return QString::asprintf("%d visible rows, expected %d", model.numItemsInGroup(0), (int)rows.size());
+        }
+        for (int row = 0; row < (int)rows.size(); row++)
+        {
+            const auto& path = rows[row];
+            if (model.pathForIndex(ListIndex(0, row)) != path)
+            {
+                return QString::asprintf("row %d maps to the wrong node", row);
+            }
+            if (model.indexForPath(path) != ListIndex(0, row))
+            {
+                return QString::asprintf("node at row %d does not map back to its row", row);
+            }
+            if (model.depthForIndex(ListIndex(0, row)) != (int)path.size() - 1)
+            {
+                return QString::asprintf("row %d has depth %d, expected %d", row, model.depthForIndex(ListIndex(0, row)), (int)path.size() - 1);
+            }
+            if (model.isExpanded(path) != model.node(path).expanded)
+            {
+                return QString::asprintf("row %d has the wrong expanded state", row);
+            }
+        }
+        for (auto& path : hidden)
+        {
+            if (!model.indexForPath(path).isEmpty())
+            {
+                return QStringLiteral("a node under a collapsed parent maps to a visible row");
+            }
+        }
+        return view.getPriv()->verifyLayout();
+    };
+
+    for (int step = 0; step < steps && failures < 10; step++)
+    {
+        const char* op = "";
+        switch (rng() % 7)
+        {
+        case 0:
+        case 1:
+        {
+            // 展开或折叠任意节点，包括祖先折叠、当前不可见的节点
+            op = "toggle";
+            auto path = model.randomPath();
+            if (path.empty())
+            {
+                continue;
+            }
+            model.toggle(path);
+            break;
+        }
+        case 2:
+        {
+            op = "insert_children";
+            auto path = model.randomPath();
+            auto n = (int)model.node(path).children.size();
+            model.insertChildren(path, int(rng() % (n + 1)), 1 + int(rng() % 4));
+            break;
+        }
+        case 3:
+        {
+            op = "remove_children";
+            auto path = model.randomPath();
+            auto n = (int)model.node(path).children.size();
+            if (n == 0)
+            {
+                continue;
+            }
+            auto row = int(rng() % n);
+            model.removeChildren(path, row, 1 + int(rng() % (n - row)));
+            break;
+        }
+        case 4:
+        {
+            op = "node_updated";
+            auto path = model.randomPath();
+            if (path.empty())
+            {
+                continue;
+            }
+            model.touch(path);
+            break;
+        }
+        default:
+        {
+            op = "scroll";
+            vs->setValue(int(rng() % (unsigned)(vs->maximum() + 1)));
+            break;
+        }
+        }
+
+        auto error = check();
+        if (!error.isEmpty())
+        {
+            fail(step, op, error);
+        }
+    }
+
+    QCoreApplication::processEvents();
+    fprintf(out, "{\"label\":\"%s\",\"bench\":\"verify_tree\",\"steps\":%d,\"failures\":%d}\n",
+            config.label.c_str(), steps, failures);
+    fflush(out);
+    return failures;
+}
@@ -0,0 +1,52 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "benchmodel.h"
+#include <cstdio>
+#include <string>
+
+/**
+ * 复杂度回归校验
+ * 在滚动的同时通过 begin/end 接口对数据模型做随机修改，每一步之后：
+ * 1. 调用 ListViewPriv::verifyLayout 校验已加载视图的位置、高度缓存与 contentHeight 的一致性；
+ * 2. 对比 ListView 的选中列表与按相同规则推算出的期望值；
+ * 3. 通过 ListViewStats 校验代价上界，例如插入 k 个数据项只能调用 k 次 heightForIndex，
+ *    一次滚动生成的视图数量不能超过 滚动距离 / 最小行高 + 2 ；
+ * 4. 观察同一源模型的过滤与排序代理模型与暴力重新计算的结果一致；显示代理模型的视图在通知过程中读到的映射都指向存在的源数据项。
+ * 需要定义 LISTVIEW_STATS 。
+ */
+class Verifier
+{
+public:
+    struct Config
+    {
+        int groupSize = 100;
+        bool headers = false;
+        ListView::LayoutMode layout = ListView::ListLayout;
+        ListView::AnchorMode anchor = ListView::AnchorTop;
+        int width = 400;
+        int height = 800;
+        unsigned seed = 20200501;
+        // 已转义为 JSON 字符串的内容
+        std::string label;
+    };
+
+    Verifier(const Config& config, FILE* out) : config(config), out(out) {}
+
+    /**
+     * @return 校验失败的步数
+     */
+    int run(BenchModel::Distribution dist, size_t rows, int steps);
+
+    /**
+     * 对树形数据模型随机展开、折叠与增删子节点，每一步之后把行与路径的换算与直接展平的结果对比，并校验布局
+     * @return 校验失败的步数
+     */
+    int runTree(int steps);
+
+private:
+    const Config config;
+    FILE* out;
+};
+
+#endif // VERIFIER_H
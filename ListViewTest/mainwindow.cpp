@@ -164,6 +164,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     listView = new ListView(nullptr);
     listView->resize(300, 500);
+    // 切换数据模型时保留布局状态，切换回来时不需要重新计算
+    listView->setModelCacheSize(2);
     listView->setDataModel(testModel);
     listView->setViewDelegate(testModel);
     listView->show();